@@ -159,7 +159,9 @@ class debug
   print_debug_string(const std::string& str);
 
   static bool
-  slot_active(const debug_int& allowed);
+  slot_active(const debug_int& allowed){
+    return bool(current_bitmask_ & allowed);
+  }
 
   static void
   print_all_debug_slots(std::ostream& os);
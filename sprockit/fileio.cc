@@ -14,6 +14,11 @@
 #include <sprockit/fileio.h>
 #include <sprockit/errors.h>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace sprockit {
 std::list<std::string> SpktFileIO::file_paths_;
 
@@ -42,6 +47,80 @@ SpktFileIO::open_file(std::ifstream& in, const std::string& filename)
   }
 }
 
+void
+SpktFileIO::open_file(mapped_file& file, const std::string& filename)
+{
+  if (file.open(filename)) {
+    return;
+  }
+
+  std::list<std::string>::const_iterator it, end = file_paths_.end();
+  for (it=file_paths_.begin(); it != end; ++it) {
+    std::string fullpath = (*it) + "/" + filename;
+    if (file.open(fullpath)) {
+      return;
+    }
+  }
+}
+
+mapped_file::mapped_file() :
+  data_(0), size_(0), mapped_(false), open_(false)
+{
+}
+
+mapped_file::~mapped_file()
+{
+  close();
+}
+
+bool
+mapped_file::open(const std::string& filename)
+{
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* ptr = ::mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr != MAP_FAILED) {
+      data_ = static_cast<const char*>(ptr);
+      size_ = st.st_size;
+      mapped_ = true;
+    }
+  }
+
+  if (!mapped_) {
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+      buffer_.append(buf, n);
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+  ::close(fd);
+  path_ = filename;
+  open_ = true;
+  return true;
+}
+
+void
+mapped_file::close()
+{
+  if (mapped_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+  buffer_.clear();
+  path_.clear();
+  data_ = 0;
+  size_ = 0;
+  mapped_ = false;
+  open_ = false;
+}
+
 void
 SpktFileIO::not_found(const std::string& filename)
 {
@@ -12,12 +12,64 @@
 #ifndef SPROCKIT_FILEIO_H_INCLUDED
 #define SPROCKIT_FILEIO_H_INCLUDED
 
+#include <sprockit/string_ref.h>
 #include <iostream>
 #include <fstream>
 #include <list>
 
 namespace sprockit {
 
+/**
+ * The whole contents of a file, mapped read-only into memory.
+ * Parsers scan contents() in place instead of copying it line by line.
+ * Files that cannot be mapped, such as pipes, are read into a buffer instead.
+ */
+class mapped_file
+{
+ public:
+  mapped_file();
+
+  ~mapped_file();
+
+  /**
+   * @return Whether the file could be opened
+   */
+  bool
+  open(const std::string& filename);
+
+  void
+  close();
+
+  bool
+  is_open() const {
+    return open_;
+  }
+
+  string_ref
+  contents() const {
+    return string_ref(data_, size_);
+  }
+
+  /**
+   * @return The path the file was opened with
+   */
+  const std::string&
+  path() const {
+    return path_;
+  }
+
+ private:
+  mapped_file(const mapped_file&);
+  mapped_file& operator=(const mapped_file&);
+
+  const char* data_;
+  size_t size_;
+  bool mapped_;
+  bool open_;
+  std::string path_;
+  std::string buffer_;
+};
+
 class SpktFileIO
 {
 
@@ -27,6 +79,8 @@ class SpktFileIO
  public:
   static void open_file(std::ifstream& stream, const std::string& filename);
 
+  static void open_file(mapped_file& file, const std::string& filename);
+
   static void add_path(const std::string& path);
 
   static void not_found(const std::string& filename);
@@ -8,6 +8,7 @@
 #include <sprockit/unordered.h>
 
 #include <cstdio>
+#include <pthread.h>
 
 namespace sprockit {
 
@@ -25,6 +26,24 @@ bool KeywordRegistration::do_validation_ = false;
 #endif
 static need_delete_statics<KeywordRegistration> del_statics;
 
+//parameter files may be validated from several threads at once, while
+//registration normally happens in static initializers
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static pthread_rwlock_t registry_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+class registry_guard
+{
+ public:
+  registry_guard(bool write){
+    if (write) pthread_rwlock_wrlock(&registry_lock);
+    else pthread_rwlock_rdlock(&registry_lock);
+  }
+
+  ~registry_guard(){
+    pthread_rwlock_unlock(&registry_lock);
+  }
+};
+
 static const char* removed_keywords[] = {
   "launch_name"
 };
@@ -42,6 +61,7 @@ bool
 KeywordRegistration::is_valid_namespace(const std::string& ns)
 {
   init();
+  registry_guard guard(false);
   spkt_unordered_set<std::string>::const_iterator
     it = valid_namespaces_->find(ns);
   if (it != valid_namespaces_->end()) {
@@ -64,6 +84,7 @@ bool
 KeywordRegistration::is_valid_keyword(const std::string &name)
 {
   init();
+  registry_guard guard(false);
   spkt_unordered_set<std::string>::const_iterator
     it = valid_keywords_->find(name);
   if (it != valid_keywords_->end()) {
@@ -90,6 +111,7 @@ void
 KeywordRegistration::register_namespace(const std::string &name)
 {
   init();
+  registry_guard guard(true);
   valid_namespaces_->insert(name);
 }
 
@@ -97,6 +119,7 @@ void
 KeywordRegistration::register_keyword(const std::string &name)
 {
   init();
+  registry_guard guard(true);
   valid_keywords_->insert(name);
 }
 
@@ -104,29 +127,33 @@ void
 KeywordRegistration::register_regexp(const std::string &regexp)
 {
   init();
+  registry_guard guard(true);
   regexps_->push_back(regexp);
 }
 
 void
 KeywordRegistration::init()
 {
-  if (inited_) {
-    return;
-  }
+  pthread_once(&init_once, &KeywordRegistration::do_init);
+}
 
+void
+KeywordRegistration::do_init()
+{
   valid_keywords_ = new spkt_unordered_set<std::string>;
   valid_namespaces_ = new spkt_unordered_set<std::string>;
   regexps_ = new std::list<std::string>;
 
   inited_ = true;
 
-  register_regexp("launch_app\\d+");
-  register_regexp("launch_app\\d+_size");
-  register_regexp("launch_app\\d+_start");
-  register_regexp("launch_app\\d+_ntask_per_node");
-  register_regexp("launch_app\\d+_argv");
-  register_regexp("launch_app\\d+_cmd");
-  register_regexp("launch_app\\d+_type");
+  //not register_regexp, which would wait on this initialization
+  regexps_->push_back("launch_app\\d+");
+  regexps_->push_back("launch_app\\d+_size");
+  regexps_->push_back("launch_app\\d+_start");
+  regexps_->push_back("launch_app\\d+_ntask_per_node");
+  regexps_->push_back("launch_app\\d+_argv");
+  regexps_->push_back("launch_app\\d+_cmd");
+  regexps_->push_back("launch_app\\d+_type");
 
   removed_ = new spkt_unordered_set<std::string>;
   int num_removed = sizeof(removed_keywords) / sizeof(const char*);
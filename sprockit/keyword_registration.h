@@ -26,8 +26,14 @@ class KeywordRegistration
 
   static bool inited_;
 
+  /**
+   * Registration and lookups are locked, so keywords
+   * can be validated from many threads at once
+   */
   static void init();
 
+  static void do_init();
+
  public:
   static void register_regexp(const std::string& regexp);
 
@@ -0,0 +1,220 @@
+#ifndef SPROCKIT_PARAM_HANDLE_H
+#define SPROCKIT_PARAM_HANDLE_H
+
+#include <sprockit/sim_parameters.h>
+#include <vector>
+
+namespace sprockit {
+
+/**
+ * A parameter read resolved once: key, scope (including values inherited
+ * from a parent) and conversion, e.g.
+ *   param_handle<double> lat(params, "latency", &sim_parameters::get_time_param);
+ *   double t = lat.get();
+ * Reading is a comparison and a copy. A handle stays valid across
+ * overrides: any write to any parameter makes the next get() resolve again.
+ * The handle must not outlive the sim_parameters it reads from.
+ */
+template <class T>
+class param_handle
+{
+ public:
+  typedef T (sim_parameters::*getter)(const param_key&);
+
+  param_handle() :
+    params_(0), key_(""), get_(0), optional_(false),
+    generation_(0), valid_(false)
+  {
+  }
+
+  param_handle(sim_parameters* params, const param_key& key, getter get) :
+    params_(params), key_(key), get_(get), optional_(false), valid_(false)
+  {
+    refresh();
+  }
+
+  /**
+   * @param def The value if the key is not set in this scope or any parent
+   */
+  param_handle(sim_parameters* params, const param_key& key, getter get, const T& def) :
+    params_(params), key_(key), get_(get), optional_(true), def_(def), valid_(false)
+  {
+    refresh();
+  }
+
+  const T&
+  get() {
+    if (!valid_ || generation_ != sim_parameters::write_generation()){
+      refresh();
+    }
+    return value_;
+  }
+
+  operator const T&() {
+    return get();
+  }
+
+  const param_key&
+  key() const {
+    return key_;
+  }
+
+  /**
+   * Resolve again now instead of on the next get() after a write
+   */
+  void
+  refresh() {
+    if (optional_ && !params_->find_param(key_)){
+      value_ = def_;
+    } else {
+      value_ = (params_->*get_)(key_);
+    }
+    generation_ = sim_parameters::write_generation();
+    valid_ = true;
+  }
+
+ private:
+  sim_parameters* params_;
+  param_key key_;
+  getter get_;
+  bool optional_;
+  T def_;
+  T value_;
+  unsigned long generation_;
+  bool valid_;
+
+};
+
+namespace pvt {
+
+template <class Struct>
+class param_binding
+{
+ public:
+  virtual ~param_binding(){}
+
+  virtual void
+  fill(sim_parameters* params, Struct& s) const = 0;
+
+  virtual param_binding*
+  clone() const = 0;
+};
+
+template <class Struct, class T>
+class typed_param_binding : public param_binding<Struct>
+{
+ public:
+  typedef T (sim_parameters::*getter)(const param_key&);
+
+  typed_param_binding(const param_key& key, T Struct::* field, getter get,
+                      bool optional, const T& def) :
+    key_(key), field_(field), get_(get), optional_(optional), def_(def)
+  {
+  }
+
+  void
+  fill(sim_parameters* params, Struct& s) const {
+    if (optional_ && !params->find_param(key_)){
+      s.*field_ = def_;
+    } else {
+      s.*field_ = (params->*get_)(key_);
+    }
+  }
+
+  param_binding<Struct>*
+  clone() const {
+    return new typed_param_binding(*this);
+  }
+
+ private:
+  param_key key_;
+  T Struct::* field_;
+  getter get_;
+  bool optional_;
+  T def_;
+};
+
+}
+
+/**
+ * Fills a configuration struct from many parameters in one pass.
+ * Build the binder once, e.g. as a static, with one line per field,
+ *   param_binder<nic_config> binder;
+ *   binder.bind("latency", &nic_config::latency, &sim_parameters::get_time_param)
+ *         .bind_optional("mtu", &nic_config::mtu, &sim_parameters::get_byte_length_param, 4096L);
+ * and then call binder.fill(params, cfg) for each component.
+ * Keys are made when the binder is built, not looked up on every fill.
+ */
+template <class Struct>
+class param_binder
+{
+ public:
+  param_binder() {}
+
+  param_binder(const param_binder& other) {
+    copy(other);
+  }
+
+  param_binder&
+  operator=(const param_binder& other) {
+    if (this != &other){
+      clear();
+      copy(other);
+    }
+    return *this;
+  }
+
+  ~param_binder() {
+    clear();
+  }
+
+  template <class T>
+  param_binder&
+  bind(const param_key& key, T Struct::* field, T (sim_parameters::*get)(const param_key&)) {
+    bindings_.push_back(new pvt::typed_param_binding<Struct,T>(key, field, get, false, T()));
+    return *this;
+  }
+
+  template <class T>
+  param_binder&
+  bind_optional(const param_key& key, T Struct::* field,
+                T (sim_parameters::*get)(const param_key&), const T& def) {
+    bindings_.push_back(new pvt::typed_param_binding<Struct,T>(key, field, get, true, def));
+    return *this;
+  }
+
+  void
+  fill(sim_parameters* params, Struct& s) const {
+    for (size_t i=0; i < bindings_.size(); ++i){
+      bindings_[i]->fill(params, s);
+    }
+  }
+
+  size_t
+  size() const {
+    return bindings_.size();
+  }
+
+ private:
+  void
+  copy(const param_binder& other) {
+    for (size_t i=0; i < other.bindings_.size(); ++i){
+      bindings_.push_back(other.bindings_[i]->clone());
+    }
+  }
+
+  void
+  clear() {
+    for (size_t i=0; i < bindings_.size(); ++i){
+      delete bindings_[i];
+    }
+    bindings_.clear();
+  }
+
+  std::vector<pvt::param_binding<Struct>*> bindings_;
+
+};
+
+}
+
+#endif // SPROCKIT_PARAM_HANDLE_H
@@ -0,0 +1,85 @@
+#include <sprockit/param_image.h>
+#include <algorithm>
+
+namespace sprockit {
+
+param_image::param_image() :
+  value_ids_(new std::map<std::string, uint32_t>)
+{
+}
+
+param_image::~param_image()
+{
+  delete value_ids_;
+}
+
+void
+param_image::seal_scope()
+{
+  if (scopes_.empty()) return;
+  scope_entry& last = scopes_.back();
+  last.end = entries_.size();
+  std::sort(entries_.begin() + last.begin, entries_.end());
+}
+
+uint32_t
+param_image::begin_scope(uint32_t parent)
+{
+  seal_scope();
+  scope_entry scope;
+  scope.parent = parent;
+  scope.begin = entries_.size();
+  scope.end = scope.begin;
+  scopes_.push_back(scope);
+  return scopes_.size() - 1;
+}
+
+void
+param_image::add_value(uint32_t key, const std::string& value)
+{
+  std::map<std::string, uint32_t>::iterator it = value_ids_->find(value);
+  if (it == value_ids_->end()){
+    it = value_ids_->insert(it, std::make_pair(value, uint32_t(values_.size())));
+    values_.push_back(value);
+  }
+  value_entry entry;
+  entry.key = key;
+  entry.value = it->second;
+  entries_.push_back(entry);
+}
+
+void
+param_image::finish()
+{
+  seal_scope();
+  delete value_ids_;
+  value_ids_ = 0;
+}
+
+const std::string*
+param_image::find_local(uint32_t scope, uint32_t key) const
+{
+  const scope_entry& s = scopes_[scope];
+  value_entry probe;
+  probe.key = key;
+  std::vector<value_entry>::const_iterator end = entries_.begin() + s.end;
+  std::vector<value_entry>::const_iterator it =
+    std::lower_bound(entries_.begin() + s.begin, end, probe);
+  if (it != end && it->key == key){
+    return &values_[it->value];
+  }
+  return 0;
+}
+
+const std::string*
+param_image::find(uint32_t scope, uint32_t key) const
+{
+  while (scope != no_scope){
+    const std::string* val = find_local(scope, key);
+    if (val) return val;
+    scope = scopes_[scope].parent;
+  }
+  return 0;
+}
+
+}
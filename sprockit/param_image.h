@@ -0,0 +1,113 @@
+#ifndef SPROCKIT_PARAM_IMAGE_H
+#define SPROCKIT_PARAM_IMAGE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace sprockit {
+
+/**
+ * An immutable, flattened copy of a whole sim_parameters tree,
+ * built by sim_parameters::freeze().
+ * Each namespace becomes a scope, numbered depth-first, and holds a
+ * run of (key id, value index) entries sorted by key id. All scopes
+ * share one entries array. Identical values are stored once. Looking
+ * up a key is a binary search over a short contiguous range per scope.
+ * Nothing is written once the image is finished, so any number of
+ * threads can read from it without locking.
+ */
+class param_image
+{
+ public:
+  static const uint32_t no_scope = uint32_t(-1);
+
+  param_image();
+
+  ~param_image();
+
+  /**
+   * Start the next scope. All values of a scope must be added
+   * before the next scope is started.
+   * @param parent The enclosing scope, or no_scope for the root
+   * @return The new scope's number
+   */
+  uint32_t
+  begin_scope(uint32_t parent);
+
+  void
+  add_value(uint32_t key, const std::string& value);
+
+  /**
+   * Seal the image after the last scope. Only then are lookups valid.
+   */
+  void
+  finish();
+
+  /**
+   * @return The value of key in scope or the nearest enclosing scope
+   *         that defines it, null if none does
+   */
+  const std::string*
+  find(uint32_t scope, uint32_t key) const;
+
+  /**
+   * @return The value of key in scope itself, null if not defined there
+   */
+  const std::string*
+  find_local(uint32_t scope, uint32_t key) const;
+
+  size_t
+  num_scopes() const {
+    return scopes_.size();
+  }
+
+  size_t
+  num_entries() const {
+    return entries_.size();
+  }
+
+  size_t
+  num_values() const {
+    return values_.size();
+  }
+
+ private:
+  struct scope_entry {
+    uint32_t parent;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  struct value_entry {
+    uint32_t key;
+    uint32_t value;
+
+    bool
+    operator<(const value_entry& other) const {
+      return key < other.key;
+    }
+  };
+
+  void
+  seal_scope();
+
+  //not copyable
+  param_image(const param_image&);
+
+  param_image&
+  operator=(const param_image&);
+
+  std::vector<scope_entry> scopes_;
+  std::vector<value_entry> entries_;
+  std::vector<std::string> values_;
+
+  //while building, the index of each distinct value
+  std::map<std::string, uint32_t>* value_ids_;
+
+};
+
+}
+
+#endif // SPROCKIT_PARAM_IMAGE_H
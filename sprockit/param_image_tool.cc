@@ -0,0 +1,65 @@
+#include <sprockit/sim_parameters.h>
+#include <sprockit/keyword_registration.h>
+#include <iostream>
+#include <cstring>
+
+static void
+usage(const char* exe)
+{
+  std::cerr << "usage: " << exe << " [-f] [-v] params.ini [image]\n"
+            << "  Compile params.ini and every file it includes into a binary\n"
+            << "  parameter image (params.ini.img by default), unless the image\n"
+            << "  is already up to date. Keywords are not validated, since this\n"
+            << "  tool does not know the application's keywords; the application\n"
+            << "  validates them when it loads the image.\n"
+            << "  -f  rebuild even if the image is up to date\n"
+            << "  -v  validate keywords against those registered in this tool\n"
+            << "  -n  accepted for compatibility, the default\n";
+}
+
+int
+main(int argc, char** argv)
+{
+  bool force = false;
+  //only the application registers its keywords, so by default the image
+  //is saved unvalidated and validated when the application loads it
+  sprockit::KeywordRegistration::do_validation_ = false;
+  int argi = 1;
+  while (argi < argc && argv[argi][0] == '-'){
+    if (::strcmp(argv[argi], "-f") == 0){
+      force = true;
+    } else if (::strcmp(argv[argi], "-v") == 0){
+      sprockit::KeywordRegistration::do_validation_ = true;
+    } else if (::strcmp(argv[argi], "-n") == 0){
+      sprockit::KeywordRegistration::do_validation_ = false;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+    ++argi;
+  }
+
+  int nargs = argc - argi;
+  if (nargs < 1 || nargs > 2){
+    usage(argv[0]);
+    return 1;
+  }
+  std::string input = argv[argi];
+  std::string image = nargs == 2 ? argv[argi+1] : input + ".img";
+
+  try {
+    sprockit::sim_parameters params;
+    if (force){
+      params.parse_file(input);
+      params.save_image(image);
+    } else {
+      params.parse_file_cached(input, image);
+    }
+    std::cout << image << ": " << params.source_files().size()
+              << " source files\n";
+  } catch (const std::exception& e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+#include <sprockit/param_include_graph.h>
+#include <sprockit/keyword_registration.h>
+#include <sprockit/errors.h>
+
+#if SPKT_HAVE_CPP11
+#include <thread>
+#endif
+
+namespace sprockit {
+namespace pvt {
+
+bool
+classify_param_line(string_ref line, param_directive& d)
+{
+  if (line.empty() || line[0] == '#') {
+    //empty or a comment
+    return false;
+  }
+
+  if (line.find("set var ") != string_ref::npos) {
+    d.kind = param_directive::set_var;
+    line = line.substr(8);
+  }
+  else if (line.find('=') != string_ref::npos) {
+    d.kind = param_directive::assign;
+  }
+  else if (line.find("include") != string_ref::npos) {
+    d.kind = param_directive::include;
+    d.key = line.substr(7).trim();
+    d.value = string_ref();
+    return true;
+  }
+  else if (line.find("unset") != string_ref::npos) {
+    d.kind = param_directive::unset;
+    d.key = line.substr(5).trim();
+    d.value = string_ref();
+    return true;
+  }
+  else {
+    spkt_throw_printf(input_error, "invalid input file line of size %lu:\n%s---",
+      line.size(), line.str().c_str());
+  }
+
+  size_t eq = line.find('=');
+  if (eq == string_ref::npos){
+    d.key = line.trim();
+    d.value = string_ref();
+  } else {
+    d.key = line.substr(0, eq).trim();
+    d.value = line.substr(eq + 1).trim();
+  }
+  return true;
+}
+
+#if SPKT_HAVE_CPP11
+param_include_graph::param_include_graph(int nthreads) :
+  nthreads_(nthreads), root_(0), busy_(0)
+{
+  if (nthreads_ <= 0){
+    nthreads_ = std::thread::hardware_concurrency();
+    if (nthreads_ <= 0) nthreads_ = 1;
+  }
+}
+
+param_include_graph::~param_include_graph()
+{
+  delete root_;
+  std::map<std::string, param_file*>::iterator it, end = files_.end();
+  for (it=files_.begin(); it != end; ++it){
+    delete it->second;
+  }
+}
+
+param_file*
+param_include_graph::included(string_ref name) const
+{
+  std::map<std::string, param_file*>::const_iterator it = files_.find(name.str());
+  return it == files_.end() ? 0 : it->second;
+}
+
+void
+param_include_graph::build(const std::string& fname)
+{
+  root_ = new param_file;
+  queue_.push_back(std::make_pair(root_, string_ref(fname).trim().str()));
+
+  std::vector<std::thread> workers;
+  for (int i=1; i < nthreads_; ++i){
+    workers.push_back(std::thread(&param_include_graph::work, this));
+  }
+  work();
+  for (size_t i=0; i < workers.size(); ++i){
+    workers[i].join();
+  }
+}
+
+void
+param_include_graph::work()
+{
+  std::unique_lock<std::mutex> guard(lock_);
+  while (true){
+    while (queue_.empty() && busy_ > 0){
+      cv_.wait(guard);
+    }
+    if (queue_.empty()){
+      //nothing queued and nobody left to queue more
+      cv_.notify_all();
+      return;
+    }
+    std::pair<param_file*, std::string> next = queue_.front();
+    queue_.pop_front();
+    ++busy_;
+    guard.unlock();
+    load(next.first, next.second, next.first != root_);
+    guard.lock();
+    --busy_;
+    cv_.notify_all();
+  }
+}
+
+void
+param_include_graph::request(string_ref name)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  param_file*& f = files_[name.str()];
+  if (!f){
+    f = new param_file;
+    queue_.push_back(std::make_pair(f, name.str()));
+    cv_.notify_one();
+  }
+}
+
+void
+param_include_graph::load(param_file* f, const std::string& name, bool is_include)
+{
+  try {
+    if (is_include){
+      //look where sim_parameters::try_to_parse would, in the same order
+      std::string dir;
+      size_t pos = name.find_last_of('/');
+      if (name[0] != '/' && pos != std::string::npos){
+        dir = name.substr(0, pos + 1);
+      }
+      SpktFileIO::open_file(f->file, dir + name);
+    }
+    if (!f->file.is_open()){
+      SpktFileIO::open_file(f->file, name);
+    }
+    if (!f->file.is_open()){
+      SpktFileIO::not_found(name);
+    }
+    f->path = f->file.path();
+
+    string_ref text = f->file.contents();
+    size_t pos = 0;
+    while (pos < text.size()){
+      size_t eol = text.find('\n', pos);
+      if (eol == string_ref::npos) eol = text.size();
+      param_directive d;
+      if (classify_param_line(text.substr(pos, eol - pos).trim(), d)){
+        if (d.kind == param_directive::assign && KeywordRegistration::do_validation_){
+          size_t dot = d.key.rfind('.');
+          string_ref final_key = dot == string_ref::npos ? d.key : d.key.substr(dot + 1);
+          KeywordRegistration::validate_keyword(final_key.str(), d.value.str());
+        }
+        f->directives.push_back(d);
+        if (d.kind == param_directive::include){
+          request(d.key);
+        }
+      }
+      pos = eol + 1;
+    }
+  } catch (...) {
+    f->error = std::current_exception();
+  }
+}
+#endif
+
+}
+}
@@ -0,0 +1,127 @@
+#ifndef SPROCKIT_PARAM_INCLUDE_GRAPH_H
+#define SPROCKIT_PARAM_INCLUDE_GRAPH_H
+
+#include <sprockit/spkt_config.h>
+#include <sprockit/string_ref.h>
+#include <sprockit/fileio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#if SPKT_HAVE_CPP11
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace sprockit {
+namespace pvt {
+
+/**
+ * One line of a parameter file, classified but not yet applied.
+ * The fields view the text of the line.
+ */
+struct param_directive
+{
+  typedef enum {
+    assign,  //key = value
+    set_var, //set var key = value
+    include, //include key
+    unset    //unset key
+  } kind_t;
+
+  kind_t kind;
+  string_ref key;
+  string_ref value;
+};
+
+/**
+ * @param line A trimmed line of a parameter file
+ * @return False for blank lines and comments
+ * @throw input_error If the line is not valid syntax
+ */
+bool
+classify_param_line(string_ref line, param_directive& d);
+
+#if SPKT_HAVE_CPP11
+/**
+ * A parameter file, read and split into directives
+ */
+struct param_file
+{
+  std::string path;
+  mapped_file file;
+  std::vector<param_directive> directives;
+  //raised after the directives are applied, where a serial parse would stop
+  std::exception_ptr error;
+  //set while the file is being applied, to catch include cycles
+  bool applying;
+
+  param_file() : applying(false) {}
+};
+
+/**
+ * Reads a parameter file and every file it includes, several files at a
+ * time. Each file is mapped, split into directives and has its keywords
+ * validated on whichever thread picks it up. The includes it names are
+ * queued as soon as they are seen. Nothing is applied here. The caller
+ * walks the directives from root() in file order, which gives exactly
+ * the overrides of a serial parse. Each distinct include is read once,
+ * however often it is included.
+ */
+class param_include_graph
+{
+ public:
+  /**
+   * @param nthreads The number of threads reading files, 0 for one per core
+   */
+  param_include_graph(int nthreads);
+
+  ~param_include_graph();
+
+  void
+  build(const std::string& fname);
+
+  param_file*
+  root() const {
+    return root_;
+  }
+
+  /**
+   * @param name The path as written after include
+   */
+  param_file*
+  included(string_ref name) const;
+
+  size_t
+  num_files() const {
+    return files_.size() + 1;
+  }
+
+ private:
+  void
+  work();
+
+  void
+  load(param_file* f, const std::string& name, bool is_include);
+
+  void
+  request(string_ref name);
+
+  int nthreads_;
+  param_file* root_;
+  std::string root_name_;
+  //includes by the name they were written with
+  std::map<std::string, param_file*> files_;
+  std::deque<std::pair<param_file*, std::string> > queue_;
+  int busy_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+};
+#endif
+
+}
+}
+
+#endif // SPROCKIT_PARAM_INCLUDE_GRAPH_H
@@ -0,0 +1,169 @@
+#include <sprockit/spkt_config.h>
+#include <sprockit/param_key.h>
+#include <sprockit/statics.h>
+#include <vector>
+#if SPKT_HAVE_CPP11
+#include <mutex>
+#endif
+
+namespace sprockit {
+namespace pvt {
+
+struct interned_name
+{
+  std::string name;
+  size_t hash;
+  uint32_t id;
+};
+
+/**
+ * Open addressing with linear probing, kept at most half full. Each slot
+ * and each by_id entry is written once, before the count that covers it
+ * is published, so readers probe without a lock. Growing builds a new
+ * table and publishes it with one store. The old table stays readable
+ * until delete_statics, which at most doubles the memory held.
+ */
+struct intern_table
+{
+  size_t mask;
+  uint32_t count;
+  interned_name** slots;
+  interned_name** by_id;
+  intern_table* retired;
+
+  intern_table(size_t capacity) :
+    mask(capacity - 1), count(0), retired(0)
+  {
+    slots = new interned_name*[capacity]();
+    by_id = new interned_name*[capacity / 2]();
+  }
+
+  ~intern_table() {
+    delete[] slots;
+    delete[] by_id;
+  }
+
+  interned_name*
+  find(string_ref name, size_t hash) const {
+    for (size_t i = hash & mask; ; i = (i + 1) & mask){
+      interned_name* entry = __atomic_load_n(&slots[i], __ATOMIC_ACQUIRE);
+      if (!entry) return 0;
+      if (entry->hash == hash && string_ref(entry->name) == name) return entry;
+    }
+  }
+
+  void
+  insert(interned_name* entry) {
+    size_t i = entry->hash & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    __atomic_store_n(&by_id[entry->id], entry, __ATOMIC_RELEASE);
+    __atomic_store_n(&slots[i], entry, __ATOMIC_RELEASE);
+  }
+};
+
+}
+
+const uint32_t param_key::no_id;
+pvt::intern_table* param_key::table_ = 0;
+static need_delete_statics<param_key> del_statics;
+
+#if SPKT_HAVE_CPP11
+//only adding a name is locked - lookups read the published table
+static std::mutex intern_lock;
+#define lock_interned() std::lock_guard<std::mutex> guard(intern_lock)
+#else
+#define lock_interned()
+#endif
+
+uint32_t
+param_key::find(string_ref name)
+{
+  pvt::intern_table* table = __atomic_load_n(&table_, __ATOMIC_ACQUIRE);
+  if (!table) return no_id;
+  pvt::interned_name* entry = table->find(name, name.hash());
+  return entry ? entry->id : no_id;
+}
+
+uint32_t
+param_key::intern(string_ref name)
+{
+  uint32_t id = find(name);
+  if (id != no_id) return id;
+
+  lock_interned();
+  size_t hash = name.hash();
+  pvt::intern_table* table = table_;
+  if (table){
+    //another thread may have added it since
+    pvt::interned_name* entry = table->find(name, hash);
+    if (entry) return entry->id;
+  }
+
+  if (!table || 2*(table->count + 1) > table->mask + 1){
+    size_t capacity = table ? 2*(table->mask + 1) : 1024;
+    pvt::intern_table* grown = new pvt::intern_table(capacity);
+    if (table){
+      for (uint32_t i=0; i < table->count; ++i){
+        grown->insert(table->by_id[i]);
+      }
+      grown->count = table->count;
+    }
+    grown->retired = table;
+    __atomic_store_n(&table_, grown, __ATOMIC_RELEASE);
+    table = grown;
+  }
+
+  pvt::interned_name* entry = new pvt::interned_name;
+  entry->name = name.str();
+  entry->hash = hash;
+  entry->id = table->count;
+  table->insert(entry);
+  __atomic_store_n(&table->count, table->count + 1, __ATOMIC_RELEASE);
+  return entry->id;
+}
+
+uint32_t
+param_key::resolve() const
+{
+  uint32_t id = find(name_);
+  if (id != no_id){
+    __atomic_store_n(&id_, id, __ATOMIC_RELAXED);
+  }
+  return id;
+}
+
+uint32_t
+param_key::interned_id() const
+{
+  uint32_t id = this->id();
+  if (id == no_id){
+    id = intern(name_);
+    __atomic_store_n(&id_, id, __ATOMIC_RELAXED);
+  }
+  return id;
+}
+
+const std::string&
+param_key::key_name(uint32_t id)
+{
+  pvt::intern_table* table = __atomic_load_n(&table_, __ATOMIC_ACQUIRE);
+  return __atomic_load_n(&table->by_id[id], __ATOMIC_ACQUIRE)->name;
+}
+
+void
+param_key::delete_statics()
+{
+  pvt::intern_table* table = table_;
+  if (!table) return;
+  for (uint32_t i=0; i < table->count; ++i){
+    delete table->by_id[i];
+  }
+  while (table){
+    pvt::intern_table* retired = table->retired;
+    delete table;
+    table = retired;
+  }
+  table_ = 0;
+}
+
+}
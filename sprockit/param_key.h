@@ -0,0 +1,113 @@
+#ifndef SPROCKIT_PARAM_KEY_H
+#define SPROCKIT_PARAM_KEY_H
+
+#include <sprockit/string_ref.h>
+#include <string>
+#include <stdint.h>
+
+namespace sprockit {
+
+namespace pvt {
+
+struct interned_name;
+struct intern_table;
+
+}
+
+/**
+ * A parameter name interned in a process-wide symbol table.
+ * sim_parameters stores its values by symbol id, so a lookup hashes one
+ * integer at each scope it visits, and every namespace shares the
+ * single copy of each name. Component code can make the keys it reads
+ * once, up front:
+ *   static const sprockit::param_key latency_key("latency");
+ *   double lat = params->get_time_param(latency_key);
+ * Strings still convert implicitly, at the cost of one string hash per call.
+ *
+ * Making a key only looks its name up. Names are added to the table only
+ * when a parameter is stored under them, so probing for parameters that
+ * do not exist never grows the table. A key made before its name is
+ * stored resolves on first use after. Lookups never take a lock, so keys
+ * can be made and used from any thread. Adding a name is locked with C++11.
+ */
+class param_key
+{
+ public:
+  static const uint32_t no_id = uint32_t(-1);
+
+  param_key(const std::string& name){
+    init(name);
+  }
+
+  param_key(const char* name){
+    init(name);
+  }
+
+  param_key(string_ref name){
+    init(name);
+  }
+
+  /**
+   * @return The symbol id, no_id if no parameter was ever stored
+   *         under the name
+   */
+  uint32_t
+  id() const {
+    uint32_t id = __atomic_load_n(&id_, __ATOMIC_RELAXED);
+    return id == no_id ? resolve() : id;
+  }
+
+  /**
+   * The symbol id, adding the name to the table if need be.
+   * Only for storing a parameter under the key.
+   */
+  uint32_t
+  interned_id() const;
+
+  const std::string&
+  name() const {
+    uint32_t id = __atomic_load_n(&id_, __ATOMIC_RELAXED);
+    return id == no_id ? name_ : key_name(id);
+  }
+
+  /**
+   * Adding a name that is already interned does not allocate
+   */
+  static uint32_t
+  intern(string_ref name);
+
+  /**
+   * @return The id of name, no_id if it was never interned
+   */
+  static uint32_t
+  find(string_ref name);
+
+  static const std::string&
+  key_name(uint32_t id);
+
+  static void
+  delete_statics();
+
+ private:
+  void
+  init(string_ref name){
+    id_ = find(name);
+    if (id_ == no_id) name_ = name.str();
+  }
+
+  uint32_t
+  resolve() const;
+
+  //filled in, at most once, by whichever thread first finds the name
+  mutable uint32_t id_;
+
+  //only kept for a name not yet in the table
+  std::string name_;
+
+  static pvt::intern_table* table_;
+
+};
+
+}
+
+#endif // SPROCKIT_PARAM_KEY_H
@@ -0,0 +1,275 @@
+#include <sprockit/param_versions.h>
+
+#if SPKT_HAVE_CPP11
+
+#include <sprockit/sim_parameters.h>
+#include <algorithm>
+
+namespace sprockit {
+namespace pvt {
+
+struct value_key_less {
+  bool
+  operator()(const version_node::value_type& v, uint32_t key) const {
+    return v.first < key;
+  }
+};
+
+struct child_name_less {
+  bool
+  operator()(const version_node::child_type& c, string_ref name) const {
+    return string_ref(c.first) < name;
+  }
+};
+
+const std::string*
+version_node::find_local(uint32_t key) const
+{
+  std::vector<value_type>::const_iterator it =
+    std::lower_bound(values.begin(), values.end(), key, value_key_less());
+  if (it != values.end() && it->first == key){
+    return &it->second;
+  }
+  return 0;
+}
+
+version_node*
+version_node::child(string_ref name) const
+{
+  std::vector<child_type>::const_iterator it =
+    std::lower_bound(children.begin(), children.end(), name, child_name_less());
+  if (it != children.end() && string_ref(it->first) == name){
+    return it->second;
+  }
+  return 0;
+}
+
+static version_node*
+copy_tree(const sim_parameters& params)
+{
+  version_node* node = new version_node;
+  sim_parameters::const_iterator it, end = params.end();
+  for (it=params.begin(); it != end; ++it){
+    node->values.push_back(std::make_pair(it.base()->first, it->second));
+  }
+  std::sort(node->values.begin(), node->values.end());
+
+  //namespaces are already sorted by name
+  sim_parameters::const_namespace_iterator nit, nend = params.ns_end();
+  for (nit=params.ns_begin(); nit != nend; ++nit){
+    node->children.push_back(std::make_pair(nit->first, copy_tree(*nit->second)));
+  }
+  return node;
+}
+
+static void
+release(version_node* node)
+{
+  if (--node->refcount == 0){
+    for (size_t i=0; i < node->children.size(); ++i){
+      release(node->children[i].second);
+    }
+    delete node;
+  }
+}
+
+/**
+ * Copy node, sharing its children, and apply the write to the copy
+ * or to a copy of the child named by the next segment of path
+ * @param val The new value, null to remove the key
+ */
+static version_node*
+copy_path(const version_node* node, string_ref path, uint32_t key,
+          const std::string* val)
+{
+  version_node* copy = node ? new version_node(*node) : new version_node;
+  copy->refcount = 1;
+  for (size_t i=0; i < copy->children.size(); ++i){
+    ++copy->children[i].second->refcount;
+  }
+
+  if (path.empty()){
+    std::vector<version_node::value_type>::iterator it =
+      std::lower_bound(copy->values.begin(), copy->values.end(), key, value_key_less());
+    bool found = it != copy->values.end() && it->first == key;
+    if (val && found){
+      it->second = *val;
+    } else if (val){
+      copy->values.insert(it, std::make_pair(key, *val));
+    } else if (found){
+      copy->values.erase(it);
+    }
+    return copy;
+  }
+
+  size_t dot = path.find('.');
+  string_ref name = dot == string_ref::npos ? path : path.substr(0, dot);
+  string_ref rest = dot == string_ref::npos ? string_ref() : path.substr(dot+1);
+  std::vector<version_node::child_type>::iterator it =
+    std::lower_bound(copy->children.begin(), copy->children.end(), name, child_name_less());
+  if (it != copy->children.end() && string_ref(it->first) == name){
+    version_node* old = it->second;
+    it->second = copy_path(old, rest, key, val);
+    release(old);
+  } else if (val){
+    copy->children.insert(it, std::make_pair(name.str(), copy_path(0, rest, key, val)));
+  }
+  return copy;
+}
+
+static const std::string*
+find_in(const version_node* node, string_ref ns, uint32_t key)
+{
+  if (!ns.empty()){
+    size_t dot = ns.find('.');
+    string_ref name = dot == string_ref::npos ? ns : ns.substr(0, dot);
+    const version_node* sub = node->child(name);
+    if (sub){
+      string_ref rest = dot == string_ref::npos ? string_ref() : ns.substr(dot+1);
+      const std::string* val = find_in(sub, rest, key);
+      if (val) return val;
+    }
+  }
+  return node->find_local(key);
+}
+
+}
+
+versioned_params::reader::reader(versioned_params& vp) :
+  vp_(&vp), epoch_(0), depth_(0)
+{
+  std::lock_guard<std::mutex> guard(vp_->lock_);
+  vp_->readers_.push_back(&epoch_);
+}
+
+versioned_params::reader::~reader()
+{
+  std::lock_guard<std::mutex> guard(vp_->lock_);
+  std::vector<std::atomic<uint64_t>*>& readers = vp_->readers_;
+  readers.erase(std::find(readers.begin(), readers.end(), &epoch_));
+}
+
+versioned_params::snapshot::snapshot(reader& r) :
+  reader_(r)
+{
+  if (reader_.depth_++ == 0){
+    //announce the epoch before loading the version, so that a writer either
+    //sees the announcement or published its version before our load
+    reader_.epoch_.store(reader_.vp_->epoch_.load());
+  }
+  version_ = reader_.vp_->current_.load();
+}
+
+versioned_params::snapshot::~snapshot()
+{
+  if (--reader_.depth_ == 0){
+    reader_.epoch_.store(0);
+  }
+}
+
+const std::string*
+versioned_params::snapshot::find_param(const param_key& key) const
+{
+  return version_->root->find_local(key.id());
+}
+
+const std::string*
+versioned_params::snapshot::find_param(string_ref ns, const param_key& key) const
+{
+  return pvt::find_in(version_->root, ns, key.id());
+}
+
+versioned_params::versioned_params(const sim_parameters& params) :
+  epoch_(1), version_number_(0)
+{
+  pvt::param_version* v = new pvt::param_version;
+  v->root = pvt::copy_tree(params);
+  v->number = 0;
+  v->retired_epoch = 0;
+  current_.store(v);
+}
+
+versioned_params::~versioned_params()
+{
+  for (size_t i=0; i < retired_.size(); ++i){
+    pvt::release(retired_[i]->root);
+    delete retired_[i];
+  }
+  pvt::param_version* v = current_.load();
+  pvt::release(v->root);
+  delete v;
+}
+
+void
+versioned_params::add_param_override(const std::string& key, const std::string& val)
+{
+  publish(key, &val);
+}
+
+void
+versioned_params::remove_param(const std::string& key)
+{
+  publish(key, 0);
+}
+
+void
+versioned_params::publish(const std::string& key, const std::string* val)
+{
+  string_ref path(key);
+  string_ref final_key = path;
+  string_ref ns;
+  size_t dot = path.rfind('.');
+  if (dot != string_ref::npos){
+    ns = path.substr(0, dot);
+    final_key = path.substr(dot+1);
+  }
+  uint32_t id = param_key::intern(final_key);
+
+  std::lock_guard<std::mutex> guard(lock_);
+  pvt::param_version* old = current_.load();
+  pvt::param_version* v = new pvt::param_version;
+  v->root = pvt::copy_path(old->root, ns, id, val);
+  v->number = old->number + 1;
+  v->retired_epoch = 0;
+  current_.store(v);
+  version_number_.store(v->number);
+
+  //readers that announce a later epoch can only load the new version
+  old->retired_epoch = epoch_.fetch_add(1);
+  retired_.push_back(old);
+  do_reclaim();
+}
+
+size_t
+versioned_params::reclaim()
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  do_reclaim();
+  return retired_.size();
+}
+
+void
+versioned_params::do_reclaim()
+{
+  uint64_t oldest = uint64_t(-1);
+  for (size_t i=0; i < readers_.size(); ++i){
+    uint64_t e = readers_[i]->load();
+    if (e && e < oldest) oldest = e;
+  }
+
+  size_t kept = 0;
+  for (size_t i=0; i < retired_.size(); ++i){
+    pvt::param_version* v = retired_[i];
+    if (v->retired_epoch < oldest){
+      pvt::release(v->root);
+      delete v;
+    } else {
+      retired_[kept++] = v;
+    }
+  }
+  retired_.resize(kept);
+}
+
+}
+
+#endif // SPKT_HAVE_CPP11
@@ -0,0 +1,213 @@
+#ifndef SPROCKIT_PARAM_VERSIONS_H
+#define SPROCKIT_PARAM_VERSIONS_H
+
+#include <sprockit/spkt_config.h>
+
+#if SPKT_HAVE_CPP11
+
+#include <sprockit/param_key.h>
+#include <sprockit/string_ref.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace sprockit {
+
+class sim_parameters;
+
+namespace pvt {
+
+/**
+ * One namespace in one version of a versioned_params. Nodes are immutable
+ * once published. A write copies only the nodes on the path from the root
+ * down to the namespace it changes and shares every other node with the
+ * previous version. Only writers touch the refcount, and only while
+ * holding the writer lock.
+ */
+struct version_node
+{
+  typedef std::pair<uint32_t, std::string> value_type;
+  typedef std::pair<std::string, version_node*> child_type;
+
+  //sorted by key id
+  std::vector<value_type> values;
+  //sorted by name
+  std::vector<child_type> children;
+  int refcount;
+
+  version_node() : refcount(1) {}
+
+  const std::string*
+  find_local(uint32_t key) const;
+
+  version_node*
+  child(string_ref name) const;
+};
+
+struct param_version
+{
+  version_node* root;
+  uint64_t number;
+  //the writer epoch at which this version was replaced
+  uint64_t retired_epoch;
+};
+
+}
+
+/**
+ * A parameter tree that worker threads read while a control thread
+ * overrides it. Readers never take a lock. Each snapshot pins the version
+ * that was current when it was taken. Writers are serialized among
+ * themselves and publish each new version with one atomic store.
+ *
+ * Reclamation is epoch-based. A writer bumps the global epoch after it
+ * publishes a version, and each registered reader announces the epoch
+ * in which it took its snapshot. A replaced version is freed once
+ * every active reader has announced a later epoch.
+ *
+ *   versioned_params vp(params);           //version 0 copies params
+ *   //on each worker thread
+ *   versioned_params::reader me(vp);
+ *   {
+ *     versioned_params::snapshot snap(me);
+ *     const std::string* lat = snap.find_param("node.nic", latency_key);
+ *   }
+ *   //on the control thread
+ *   vp.add_param_override("node.nic.latency", "200ns");
+ */
+class versioned_params
+{
+ public:
+  /**
+   * A thread's registration with a versioned_params.
+   * Only the owning thread may take snapshots through it.
+   */
+  class reader
+  {
+   public:
+    explicit reader(versioned_params& vp);
+
+    ~reader();
+
+   private:
+    friend class versioned_params;
+    friend class snapshot;
+
+    reader(const reader&);
+    reader& operator=(const reader&);
+
+    versioned_params* vp_;
+    //0 while not inside a snapshot
+    std::atomic<uint64_t> epoch_;
+    int depth_;
+  };
+
+  /**
+   * A consistent view of one version, held for as long as the snapshot
+   * lives. Value pointers are valid until then. Snapshots on one reader
+   * may nest, and each sees the version current when it was taken.
+   */
+  class snapshot
+  {
+   public:
+    explicit snapshot(reader& r);
+
+    ~snapshot();
+
+    uint64_t
+    version() const {
+      return version_->number;
+    }
+
+    /**
+     * @return The value of key in the top namespace, null if not defined
+     */
+    const std::string*
+    find_param(const param_key& key) const;
+
+    /**
+     * @param ns A dotted namespace path such as "node.nic". Like
+     *        sim_parameters, a key missing in ns is inherited from the
+     *        enclosing namespaces, and a namespace that does not exist
+     *        is treated as empty.
+     * @return The value of key in ns, null if not defined
+     */
+    const std::string*
+    find_param(string_ref ns, const param_key& key) const;
+
+   private:
+    snapshot(const snapshot&);
+    snapshot& operator=(const snapshot&);
+
+    reader& reader_;
+    const pvt::param_version* version_;
+  };
+
+  /**
+   * Version 0 is a copy of params and every namespace below it
+   */
+  explicit versioned_params(const sim_parameters& params);
+
+  /**
+   * All readers must have been destroyed first
+   */
+  ~versioned_params();
+
+  /**
+   * Publish a new version in which the dotted key has the value val.
+   * Namespaces that do not exist yet are created.
+   */
+  void
+  add_param_override(const std::string& key, const std::string& val);
+
+  /**
+   * Publish a new version without the dotted key
+   */
+  void
+  remove_param(const std::string& key);
+
+  /**
+   * @return The number of the newest published version
+   */
+  uint64_t
+  version() const {
+    return version_number_.load();
+  }
+
+  /**
+   * Free every replaced version that no reader can still see. Each write
+   * does this already, so it only needs calling to release memory after
+   * the last write.
+   * @return The number of replaced versions still waiting on readers
+   */
+  size_t
+  reclaim();
+
+ private:
+  versioned_params(const versioned_params&);
+  versioned_params& operator=(const versioned_params&);
+
+  void
+  publish(const std::string& key, const std::string* val);
+
+  void
+  do_reclaim();
+
+  std::atomic<pvt::param_version*> current_;
+  std::atomic<uint64_t> epoch_;
+  std::atomic<uint64_t> version_number_;
+
+  //guards everything below as well as writes and registration
+  std::mutex lock_;
+  std::vector<pvt::param_version*> retired_;
+  std::vector<std::atomic<uint64_t>*> readers_;
+
+};
+
+}
+
+#endif // SPKT_HAVE_CPP11
+
+#endif // SPROCKIT_PARAM_VERSIONS_H
@@ -21,27 +21,29 @@ namespace sprockit {
 static need_delete_statics<serializable_factory> del_statics;
 serializable_factory::builder_map* serializable_factory::builders_ = 0;
 
+namespace pvt {
+
+serializable_registration::serializable_registration(
+  serializable_builder* builder, uint32_t cls_id)
+{
+  serializable_factory::add_builder(builder, cls_id);
+}
+
+}
+
 uint32_t
 serializable_factory::add_builder(serializable_builder* builder)
+{
+  return add_builder(builder, pvt::ser_hash(builder->name()));
+}
+
+uint32_t
+serializable_factory::add_builder(serializable_builder* builder, uint32_t hash)
 {
   if (builders_ == 0) {
     builders_ = new builder_map;
   }
 
-  const char* key = builder->name();
-  int len = ::strlen(key);
-  uint32_t hash = 0;
-  for(int i = 0; i < len; ++i)
-  {
-    hash += key[i];
-    hash += (hash << 10);
-    hash ^= (hash >> 6);
-  }
-  hash += (hash << 3);
-  hash ^= (hash >> 11);
-  hash += (hash << 15);
-
-
   builder_map& bmap = *builders_;
   serializable_builder*& current = bmap[hash];
   if (current != 0){
@@ -61,6 +63,26 @@ serializable_factory::delete_statics()
   delete builders_;
 }
 
+serializable*
+serializable_factory::get_serializable(uint32_t cls_id, ser_arena* arena)
+{
+  if (arena == 0){
+    return get_serializable(cls_id);
+  }
+
+  builder_map::const_iterator it
+    = builders_->find(cls_id);
+  if (it == builders_->end()) {
+    spkt_throw_printf(value_error,
+                     "class id %ld is not a valid serializable id",
+                     cls_id);
+  }
+  serializable_builder* builder = it->second;
+  serializable* s = builder->build(arena->allocate(builder->size()));
+  arena->add_object(s);
+  return s;
+}
+
 serializable*
 serializable_factory::get_serializable(uint32_t cls_id)
 {
@@ -12,13 +12,67 @@
 #ifndef SPROCKIT_COMMON_MESSAGES_SERIALIZABLE_H_INCLUDED
 #define SPROCKIT_COMMON_MESSAGES_SERIALIZABLE_H_INCLUDED
 
+#include <sprockit/spkt_config.h>
 #include <sprockit/serializable_type.h>
+#include <sprockit/serialize_arena.h>
 #include <sprockit/unordered.h>
 #include <typeinfo>
+#include <new>
 #include <stdint.h>
 
 namespace sprockit {
 
+namespace pvt {
+
+#if SPKT_HAVE_CPP11
+#define SPKT_SER_HASH_CONSTEXPR constexpr
+#else
+#define SPKT_SER_HASH_CONSTEXPR inline
+#endif
+
+/**
+ * Jenkins one-at-a-time hash of a class name, written as single-expression
+ * functions so that with C++11 class ids are compile-time constants
+ */
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_mix(uint32_t h){
+  return h ^ (h >> 6);
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_add(uint32_t h){
+  return ser_hash_mix(h + (h << 10));
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_loop(const char* key, uint32_t h){
+  return *key ? ser_hash_loop(key + 1, ser_hash_add(h + uint32_t(*key))) : h;
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_final3(uint32_t h){
+  return h + (h << 15);
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_final2(uint32_t h){
+  return ser_hash_final3(h ^ (h >> 11));
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash_final1(uint32_t h){
+  return ser_hash_final2(h + (h << 3));
+}
+
+SPKT_SER_HASH_CONSTEXPR uint32_t
+ser_hash(const char* key){
+  return ser_hash_final1(ser_hash_loop(key, 0));
+}
+
+#undef SPKT_SER_HASH_CONSTEXPR
+
+}
+
 #define ImplementVirtualSerializable(obj) \
     protected: \
         obj(cxn_flag_t flag){}
@@ -45,6 +99,11 @@ namespace sprockit {
     throw_exc(); \
     return 0; \
   } \
+  static obj* \
+  construct_deserialize_stub(void* buf) { \
+    throw_exc(); \
+    return 0; \
+  } \
   virtual std::string \
   serialization_name() const { \
     throw_exc(); \
@@ -74,6 +133,10 @@ namespace sprockit {
   construct_deserialize_stub() { \
     return new obj; \
   } \
+  static obj* \
+  construct_deserialize_stub(void* buf) { \
+    return new (buf) obj; \
+  } \
   virtual std::string \
   serialization_name() const { \
     return #obj; \
@@ -95,6 +158,15 @@ class serializable_builder
   virtual serializable*
   build() const = 0;
 
+  /**
+   * Construct the object in place in memory of at least size() bytes
+   */
+  virtual serializable*
+  build(void* buf) const = 0;
+
+  virtual size_t
+  size() const = 0;
+
   virtual ~serializable_builder(){}
 
   virtual const char*
@@ -104,11 +176,22 @@ class serializable_builder
   sanity(serializable* ser) = 0;
 };
 
+namespace pvt {
+
+class serializable_registration
+{
+ public:
+  serializable_registration(serializable_builder* builder, uint32_t cls_id);
+};
+
+}
+
 template<class T>
 class serializable_builder_impl : public serializable_builder
 {
  protected:
   static const char* name_;
+  static pvt::serializable_registration registration_;
 
  public:
   serializable*
@@ -116,6 +199,16 @@ class serializable_builder_impl : public serializable_builder
     return T::construct_deserialize_stub();
   }
 
+  serializable*
+  build(void* buf) const {
+    return T::construct_deserialize_stub(buf);
+  }
+
+  size_t
+  size() const {
+    return sizeof(T);
+  }
+
   const char*
   name() const {
     return name_;
@@ -138,12 +231,28 @@ class serializable_factory
   static serializable*
   get_serializable(uint32_t cls_id);
 
+  /**
+   * @param cls_id
+   * @param arena If not null, construct the object in arena memory
+   *              and register it with the arena for destruction
+   */
+  static serializable*
+  get_serializable(uint32_t cls_id, ser_arena* arena);
+
   /**
       @return The cls id for the given builder
   */
   static uint32_t
   add_builder(serializable_builder* builder);
 
+  /**
+   * Register a builder under a precomputed id (see SerializableId).
+   * Aborts if another class is already registered with the id.
+   * @return cls_id
+   */
+  static uint32_t
+  add_builder(serializable_builder* builder, uint32_t cls_id);
+
   static bool
   sanity(serializable* ser, uint32_t cls_id) {
     return (*builders_)[cls_id]->sanity(ser);
@@ -160,10 +269,24 @@ class serializable_factory
 
 #define SerializableName(obj) #obj
 
+/**
+ * The class id of a type passed to DeclareSerializable, spelled the same way.
+ * With C++11 this is a constant expression (usable e.g. as a case label).
+ */
+#define SerializableId(...) \
+  ::sprockit::pvt::ser_hash(SerializableName((__VA_ARGS__)))
+
+/**
+ * With C++11 cls_id_ is constant-initialized, so it is valid even when read
+ * during static initialization of other files. Only the factory insert
+ * (and the collision check) is left to run at startup.
+ */
 #define DeclareSerializable(...) \
 namespace sprockit { \
 template<> const char* serializable_builder_impl<__VA_ARGS__ >::name_ = SerializableName((__VA_ARGS__)); \
-template<> uint32_t serializable_type<__VA_ARGS__ >::cls_id_ = serializable_factory::add_builder(new serializable_builder_impl<__VA_ARGS__ >); \
+template<> const uint32_t serializable_type<__VA_ARGS__ >::cls_id_ = SerializableId(__VA_ARGS__); \
+template<> pvt::serializable_registration serializable_builder_impl<__VA_ARGS__ >::registration_ \
+  = pvt::serializable_registration(new serializable_builder_impl<__VA_ARGS__ >, SerializableId(__VA_ARGS__)); \
 }
 
 #endif
@@ -29,7 +29,12 @@ template <class T>
 class serializable_type
 {
  protected:
-  static uint32_t cls_id_;
+  /**
+   * Defined by DeclareSerializable from SerializableId(T). Being a const
+   * with a constant initializer, it is folded into dispatch code compiled
+   * after the definition rather than loaded at each use.
+   */
+  static const uint32_t cls_id_;
 
   virtual T*
   you_forgot_to_add_ImplementSerializable_to_this_class() = 0;
@@ -44,6 +49,24 @@ class serializable_type
 
 };
 
+/**
+ * Use in place of serializable_type<T> for a class with no subclasses
+ * (declared final in C++11). Pointers to T are then packed and unpacked
+ * through direct, inlinable calls to T::serialize_order and
+ * T::construct_deserialize_stub instead of virtual dispatch and a factory
+ * lookup. The wire format is identical, so a final T packed directly
+ * can be unpacked through a base class pointer and vice versa.
+ */
+template <class T>
+class final_serializable_type : public serializable_type<T>
+{
+ public:
+  static uint32_t
+  static_cls_id() {
+    return serializable_type<T>::cls_id_;
+  }
+};
+
 }
 
 #endif // SERIALIZABLE_TYPE_H
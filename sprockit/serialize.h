@@ -4,6 +4,9 @@
 #include <sprockit/serializer.h>
 #include <sprockit/serializable_type.h>
 #include <sprockit/debug.h>
+#include <sprockit/errors.h>
+#include <sprockit/preprocessor.h>
+#include <sprockit/serialize_stats.h>
 
 DeclareDebugSlot(serialize);
 
@@ -29,6 +32,8 @@ class serialize<bool> {
 
 namespace pvt {
 
+static const long null_ptr_id = -1;
+
 void
 size_serializable(serializable* s, serializer& ser);
 
@@ -38,6 +43,12 @@ pack_serializable(serializable* s, serializer& ser);
 void
 unpack_serializable(serializable*& s, serializer& ser);
 
+void
+hash_serializable(serializable* s, serializer& ser);
+
+void
+copy_serializable(serializable*& s, serializer& ser);
+
 }
 
 
@@ -58,6 +69,13 @@ class serialize<serializable*> {
   case serializer::UNPACK:
     pvt::unpack_serializable(s,ser);
     break;
+  case serializer::HASH:
+    pvt::hash_serializable(s,ser);
+    break;
+  case serializer::COPY_SOURCE:
+  case serializer::COPY_DEST:
+    pvt::copy_serializable(s,ser);
+    break;
     }
   }
 
@@ -95,8 +113,14 @@ class serialize_ptr<T,false>
   }
 };
 
-template <class T>
-class serialize_ptr<T,true>
+namespace pvt {
+
+/**
+ * Static type is only known up to a base class - go through
+ * the virtual functions and the serializable factory
+ */
+template <class T, bool is_final>
+class serialize_serializable_ptr
 {
  public:
   void
@@ -107,6 +131,96 @@ class serialize_ptr<T,true>
   }
 };
 
+/**
+ * Static type is the dynamic type - all calls are non-virtual
+ * and can be inlined
+ */
+template <class T>
+class serialize_serializable_ptr<T,true>
+{
+ public:
+  void
+  operator()(serializer& ser, T*& t){
+#if SPKT_HAVE_CPP11
+    spkt_static_assert(__is_final(T),
+      "final_serializable_type<T> requires T to be declared final");
+#endif
+    switch (ser.mode()){
+    case serializer::SIZER: {
+      long dummy = 0;
+      ser.size(dummy);
+      if (t) t->T::serialize_order(ser);
+      break;
+    }
+    case serializer::PACK: {
+      SPKT_SER_STATS_BEGIN(ser);
+      long cls_id = t ? long(final_serializable_type<T>::static_cls_id()) : null_ptr_id;
+      ser.pack(cls_id);
+      if (t){
+        t->T::serialize_order(ser);
+        SPKT_SER_STATS_PACK(ser, cls_id, t->T::cls_name());
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      SPKT_SER_STATS_BEGIN(ser);
+      long cls_id;
+      ser.unpack(cls_id);
+      if (cls_id == null_ptr_id){
+        t = 0;
+      } else if (cls_id == long(final_serializable_type<T>::static_cls_id())){
+        ser_arena* arena = ser.unpacker().arena();
+        if (arena){
+          t = T::construct_deserialize_stub(arena->allocate(sizeof(T)));
+          arena->add_object(t);
+        } else {
+          t = T::construct_deserialize_stub();
+        }
+        t->T::serialize_order(ser);
+        SPKT_SER_STATS_UNPACK(ser, cls_id, t->T::cls_name());
+      } else {
+        spkt_throw_printf(value_error,
+          "unpacking final type %s: got class id %ld, expected %ld",
+          typeid(T).name(), cls_id,
+          long(final_serializable_type<T>::static_cls_id()));
+      }
+      break;
+    }
+    case serializer::HASH:
+    case serializer::COPY_SOURCE: {
+      long cls_id = t ? long(final_serializable_type<T>::static_cls_id()) : null_ptr_id;
+      ser.primitive(cls_id);
+      if (t) t->T::serialize_order(ser);
+      break;
+    }
+    case serializer::COPY_DEST: {
+      long cls_id;
+      ser.primitive(cls_id);
+      if (cls_id == null_ptr_id){
+        t = 0;
+      } else {
+        t = T::construct_deserialize_stub();
+        t->T::serialize_order(ser);
+      }
+      break;
+    }
+    }
+  }
+};
+
+}
+
+template <class T>
+class serialize_ptr<T,true>
+{
+ public:
+  void
+  operator()(serializer& ser, T*& t){
+    pvt::serialize_serializable_ptr<T,
+      is_base_of<T,final_serializable_type<T> >::value>()(ser, t);
+  }
+};
+
 inline void
 operator&(serializer& ser, void* v){
   ser.primitive(v);
@@ -124,9 +238,57 @@ operator&(serializer& ser, T& t){
   serialize<T>()(t, ser);
 }
 
+/**
+ * Fingerprint of everything serialize_order would write for t,
+ * computed in one pass without packing anything. Equal values of the
+ * same type hash the same on every run, and pointers are followed
+ * (serializable objects hash their class id and fields).
+ * @param seed Distinct seeds give independent hash functions
+ */
+template <class T>
+uint64_t
+content_hash(T& t, uint64_t seed = 0){
+  serializer ser;
+  ser.start_hashing(seed);
+  ser & t;
+  return ser.digest();
+}
+
+/**
+ * Copy src into dst through serialize_order, field by field, without
+ * packing a buffer. Pointers are followed: subobjects are built by the
+ * serializable factory and belong to dst exactly as after an unpack.
+ * Types need no clone() of their own.
+ */
+template <class T>
+void
+deep_copy(T& src, T& dst){
+  serializer ser;
+  ser.start_copy_source();
+  ser & src;
+  ser.start_copy_dest();
+  ser & dst;
+  ser.copier().finish();
+}
+
+/**
+ * @return A deep copy of *src with the same dynamic type, null if src is null
+ */
+template <class T>
+T*
+deep_copy(T* src){
+  T* dst = 0;
+  deep_copy(src, dst);
+  return dst;
+}
+
 }
 
 #include <sprockit/serialize_array.h>
+#include <sprockit/serialize_columnar.h>
+#include <sprockit/serialize_delta.h>
+#include <sprockit/serialize_flat.h>
+#include <sprockit/serialize_indexed.h>
 #include <sprockit/serialize_list.h>
 #include <sprockit/serialize_map.h>
 #include <sprockit/serialize_set.h>
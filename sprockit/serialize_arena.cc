@@ -0,0 +1,92 @@
+#include <sprockit/serialize_arena.h>
+#include <sprockit/serializable_type.h>
+
+namespace sprockit {
+
+ser_arena::ser_arena(size_t block_size) :
+  block_size_(block_size),
+  current_block_(0),
+  offset_(0),
+  bytes_allocated_(0)
+{
+  blocks_.push_back(new char[block_size_]);
+}
+
+ser_arena::~ser_arena()
+{
+  clear();
+  for (size_t i=0; i < blocks_.size(); ++i){
+    delete[] blocks_[i];
+  }
+}
+
+void
+ser_arena::next_block()
+{
+  ++current_block_;
+  offset_ = 0;
+  if (current_block_ == blocks_.size()){
+    blocks_.push_back(new char[block_size_]);
+  }
+}
+
+void*
+ser_arena::allocate(size_t size)
+{
+  size_t padded = (size + alignment - 1) & ~(alignment - 1);
+  bytes_allocated_ += padded;
+  if (padded > block_size_ / 2){
+    //do not waste the tail of a regular block on a big allocation
+    char* large = new char[padded];
+    large_blocks_.push_back(large);
+    large_sizes_.push_back(padded);
+    return large;
+  }
+
+  if (offset_ + padded > block_size_){
+    next_block();
+  }
+  char* ptr = blocks_[current_block_] + offset_;
+  offset_ += padded;
+  return ptr;
+}
+
+void
+ser_arena::clear()
+{
+  std::vector<serializable*>::reverse_iterator it, end = objects_.rend();
+  for (it=objects_.rbegin(); it != end; ++it){
+    serializable* s = *it;
+    s->~serializable();
+  }
+  objects_.clear();
+
+  for (size_t i=0; i < large_blocks_.size(); ++i){
+    delete[] large_blocks_[i];
+  }
+  large_blocks_.clear();
+  large_sizes_.clear();
+
+  current_block_ = 0;
+  offset_ = 0;
+  bytes_allocated_ = 0;
+}
+
+bool
+ser_arena::owns(const void* ptr) const
+{
+  const char* cptr = reinterpret_cast<const char*>(ptr);
+  for (size_t i=0; i <= current_block_ && i < blocks_.size(); ++i){
+    if (cptr >= blocks_[i] && cptr < blocks_[i] + block_size_){
+      return true;
+    }
+  }
+  for (size_t i=0; i < large_blocks_.size(); ++i){
+    if (cptr >= large_blocks_[i] && cptr < large_blocks_[i] + large_sizes_[i]){
+      return true;
+    }
+  }
+  return false;
+}
+
+}
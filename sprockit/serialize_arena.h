@@ -0,0 +1,81 @@
+#ifndef SERIALIZE_ARENA_H
+#define SERIALIZE_ARENA_H
+
+#include <sprockit/serializable_fwd.h>
+#include <vector>
+#include <cstddef>
+
+namespace sprockit {
+
+/**
+ * A bump allocator for unpacking one message. Pass it to
+ * serializer::start_unpacking and every object and binary buffer decoded
+ * from the message is carved out of the arena instead of being individually
+ * allocated with new. Calling clear() (or destroying the arena) runs the
+ * destructors of all unpacked objects and releases everything in one shot.
+ * Memory blocks are kept across clear() so that a long-lived arena stops
+ * touching the heap once it has grown to the size of the largest message.
+ *
+ * Objects unpacked into an arena are owned by the arena: they must not be
+ * deleted or held by a refcount_ptr, and their destructors must not delete
+ * subobjects or buffers that were unpacked with them (see owns()).
+ * An arena is not thread-safe.
+ */
+class ser_arena
+{
+ public:
+  static const size_t alignment = 16;
+
+  ser_arena(size_t block_size = 64*1024);
+
+  ~ser_arena();
+
+  void*
+  allocate(size_t size);
+
+  /**
+   * Register an object constructed in arena memory so that
+   * its destructor is run on clear()
+   */
+  void
+  add_object(serializable* s){
+    objects_.push_back(s);
+  }
+
+  /**
+   * Destroy all objects (in reverse order of unpacking)
+   * and make all memory available for reuse
+   */
+  void
+  clear();
+
+  /**
+   * @return Whether ptr points into memory handed out by this arena
+   */
+  bool
+  owns(const void* ptr) const;
+
+  size_t
+  bytes_allocated() const {
+    return bytes_allocated_;
+  }
+
+ private:
+  void
+  next_block();
+
+ private:
+  size_t block_size_;
+  std::vector<char*> blocks_;
+  std::vector<char*> large_blocks_;
+  std::vector<size_t> large_sizes_;
+  std::vector<serializable*> objects_;
+  size_t current_block_;
+  size_t offset_;
+  size_t bytes_allocated_;
+
+};
+
+}
+
+#endif // SERIALIZE_ARENA_H
@@ -0,0 +1,133 @@
+#include <sprockit/serialize_batch.h>
+
+namespace sprockit {
+
+ser_batch_packer::ser_batch_packer(size_t initial_size) :
+  buf_(initial_size ? initial_size : 1),
+  size_(0),
+  finished_(false)
+{
+}
+
+void
+ser_batch_packer::grow(size_t min_size)
+{
+  size_t new_size = buf_.size() * 2;
+  while (new_size < min_size) new_size *= 2;
+  buf_.resize(new_size);
+}
+
+void
+ser_batch_packer::add(serializable* msg)
+{
+  if (finished_){
+    spkt_throw_printf(illformed_error,
+      "ser_batch_packer::add: batch already finished - call clear() first");
+  }
+  if (size_ > uint32_t(-1)){
+    spkt_throw_printf(value_error,
+      "ser_batch_packer::add: batch exceeds 4 GB");
+  }
+
+  if (!pvt::ser_default_policy::checked){
+    //trusted buffers never report an overrun - size up front instead
+    ser_.start_sizing();
+    ser_ & msg;
+    if (size_ + ser_.size() > buf_.size()){
+      grow(size_ + ser_.size());
+    }
+  }
+
+  while (true){
+    ser_.start_packing(&buf_[0] + size_, buf_.size() - size_);
+    try {
+      ser_ & msg;
+      break;
+    } catch (pvt::ser_buffer_overrun& e) {
+      grow(buf_.size() + 1);
+    }
+  }
+  offsets_.push_back(size_);
+  size_ += ser_.size();
+}
+
+char*
+ser_batch_packer::finish(size_t& size)
+{
+  if (!finished_){
+    uint32_t n = offsets_.size();
+    size_t index_size = (n + 1) * sizeof(uint32_t);
+    if (size_ + index_size > buf_.size()){
+      grow(size_ + index_size);
+    }
+    if (n) ::memcpy(&buf_[0] + size_, &offsets_[0], n * sizeof(uint32_t));
+    ::memcpy(&buf_[0] + size_ + n*sizeof(uint32_t), &n, sizeof(uint32_t));
+    finished_ = true;
+  }
+  size = size_ + (offsets_.size() + 1) * sizeof(uint32_t);
+  return &buf_[0];
+}
+
+void
+ser_batch_packer::clear()
+{
+  offsets_.clear();
+  size_ = 0;
+  finished_ = false;
+}
+
+ser_batch_unpacker::ser_batch_unpacker(char* buf, size_t size, ser_arena* arena) :
+  buf_(buf),
+  index_(0),
+  data_size_(0),
+  count_(0),
+  next_(0),
+  arena_(arena)
+{
+  uint32_t n;
+  if (size < sizeof(uint32_t)){
+    spkt_throw_printf(value_error,
+      "ser_batch_unpacker: buffer of size %lu is too small for a batch", size);
+  }
+  ::memcpy(&n, buf + size - sizeof(uint32_t), sizeof(uint32_t));
+  size_t index_size = (size_t(n) + 1) * sizeof(uint32_t);
+  if (index_size > size){
+    spkt_throw_printf(value_error,
+      "ser_batch_unpacker: batch of size %lu cannot hold %u messages", size, n);
+  }
+  count_ = n;
+  data_size_ = size - index_size;
+  index_ = buf + data_size_;
+}
+
+serializable*
+ser_batch_unpacker::get(size_t idx)
+{
+  if (idx >= count_){
+    spkt_throw_printf(value_error,
+      "ser_batch_unpacker: message %lu out of range for batch of %lu",
+      idx, count_);
+  }
+  uint32_t offset;
+  ::memcpy(&offset, index_ + idx*sizeof(uint32_t), sizeof(uint32_t));
+  if (offset > data_size_){
+    spkt_throw_printf(value_error,
+      "ser_batch_unpacker: corrupt offset %u for message %lu", offset, idx);
+  }
+  serializable* msg = 0;
+  ser_.start_unpacking(buf_ + offset, data_size_ - offset, arena_);
+  ser_ & msg;
+  return msg;
+}
+
+bool
+ser_batch_unpacker::next(serializable*& msg)
+{
+  if (next_ == count_){
+    return false;
+  }
+  msg = get(next_++);
+  return true;
+}
+
+}
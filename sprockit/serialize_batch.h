@@ -0,0 +1,112 @@
+#ifndef SERIALIZE_BATCH_H
+#define SERIALIZE_BATCH_H
+
+#include <sprockit/serialize.h>
+#include <vector>
+#include <stdint.h>
+
+namespace sprockit {
+
+/**
+ * Coalesces many small serializable messages into one buffer, e.g. all
+ * events headed for the same destination. Messages are packed back to back
+ * with a single reused serializer - there is no sizing pass, the buffer
+ * just doubles when a message does not fit (unless configured with
+ * trusted serialization, which cannot detect that). finish() appends the index:
+ *   uint32 offset[n], uint32 n
+ * so the receiver can walk the batch or jump to any message.
+ */
+class ser_batch_packer
+{
+ public:
+  ser_batch_packer(size_t initial_size = 4096);
+
+  void
+  add(serializable* msg);
+
+  size_t
+  count() const {
+    return offsets_.size();
+  }
+
+  /**
+   * @return The number of bytes packed so far, without the index
+   */
+  size_t
+  size() const {
+    return size_;
+  }
+
+  /**
+   * Append the index. No messages can be added until clear().
+   * @param size [out] The total size of the batch
+   * @return The batch buffer, valid until the next clear() or add()
+   */
+  char*
+  finish(size_t& size);
+
+  /**
+   * Start a new batch, keeping the buffer
+   */
+  void
+  clear();
+
+ private:
+  void
+  grow(size_t min_size);
+
+ private:
+  std::vector<char> buf_;
+  std::vector<uint32_t> offsets_;
+  size_t size_;
+  bool finished_;
+  serializer ser_;
+
+};
+
+/**
+ * Reads a batch made by ser_batch_packer, in place
+ */
+class ser_batch_unpacker
+{
+ public:
+  /**
+   * @param buf
+   * @param size
+   * @param arena If not null, unpack all messages into the arena
+   */
+  ser_batch_unpacker(char* buf, size_t size, ser_arena* arena = 0);
+
+  size_t
+  count() const {
+    return count_;
+  }
+
+  /**
+   * Unpack the message at position idx
+   */
+  serializable*
+  get(size_t idx);
+
+  /**
+   * Unpack the messages in order
+   * @param msg [out]
+   * @return False once all messages have been returned
+   */
+  bool
+  next(serializable*& msg);
+
+ private:
+  char* buf_;
+  const char* index_;
+  size_t data_size_;
+  size_t count_;
+  size_t next_;
+  ser_arena* arena_;
+  serializer ser_;
+
+};
+
+}
+
+#endif // SERIALIZE_BATCH_H
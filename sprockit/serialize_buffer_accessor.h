@@ -1,6 +1,7 @@
 #ifndef SERIALIZE_ACCESSOR_H
 #define SERIALIZE_ACCESSOR_H
 
+#include <sprockit/spkt_config.h>
 #include <cstring>
 #include <sprockit/errors.h>
 
@@ -9,33 +10,95 @@ namespace pvt {
 
 class ser_buffer_overrun : public spkt_error {
  public:
-  ser_buffer_overrun(int maxsize) :
-    spkt_error(sprockit::printf("serialization overrun buffer of size %d", maxsize))
+  ser_buffer_overrun(size_t maxsize) :
+    spkt_error(sprockit::printf("serialization overrun buffer of size %lu", maxsize))
   {
   }
+
+  ser_buffer_overrun(size_t maxsize, size_t needed) :
+    spkt_error(sprockit::printf("serialization overrun buffer of size %lu: need %lu bytes",
+                                maxsize, needed))
+  {
+  }
+};
+
+/**
+ * Bounds check every access. Use for buffers that come from outside.
+ */
+struct ser_checked_policy {
+  static const bool checked = true;
+};
+
+/**
+ * Skip bounds checks. Use only for buffers that were sized and packed
+ * by this process (or a trusted peer) with a matching serialize_order.
+ */
+struct ser_trusted_policy {
+  static const bool checked = false;
 };
 
+#if SPKT_TRUSTED_SERIALIZATION
+typedef ser_trusted_policy ser_default_policy;
+#else
+typedef ser_checked_policy ser_default_policy;
+#endif
+
 class ser_buffer_accessor {
  public:
   template <class T>
   T*
+  next(){
+    return next<T,ser_default_policy>();
+  }
+
+  template <class T, class Policy>
+  T*
   next(){
     T* ser_buffer = reinterpret_cast<T*>(bufptr_);
     bufptr_ += sizeof(T);
     size_ += sizeof(T);
-    if (size_ > max_size_) throw ser_buffer_overrun(max_size_);
+    if (Policy::checked && size_ > max_size_) throw ser_buffer_overrun(max_size_, size_);
     return ser_buffer;
   }
 
   char*
   next_str(size_t size){
+    return next_str<ser_default_policy>(size);
+  }
+
+  template <class Policy>
+  char*
+  next_str(size_t size){
+    if (Policy::checked && size > max_size_ - size_){
+      //compare against remaining space so a bogus size cannot wrap around
+      throw ser_buffer_overrun(max_size_, size_ + size);
+    }
     char* ser_buffer = reinterpret_cast<char*>(bufptr_);
     bufptr_ += size;
     size_ += size;
-    if (size_ > max_size_) throw ser_buffer_overrun(max_size_);
     return ser_buffer;
   }
 
+  /**
+   * Verify up front that a run of elements fits in the buffer so that
+   * the individual elements can be accessed with ser_trusted_policy
+   * @param count The number of elements
+   * @param elem_size The size of each element in bytes
+   */
+  void
+  check_capacity(size_t count, size_t elem_size = 1){
+    check_capacity<ser_default_policy>(count, elem_size);
+  }
+
+  template <class Policy>
+  void
+  check_capacity(size_t count, size_t elem_size = 1){
+    if (Policy::checked && elem_size
+        && count > (max_size_ - size_) / elem_size){
+      throw ser_buffer_overrun(max_size_, size_ + count*elem_size);
+    }
+  }
+
   size_t
   size() const {
     return size_;
@@ -46,6 +109,11 @@ class ser_buffer_accessor {
     return max_size_;
   }
 
+  size_t
+  remaining() const {
+    return max_size_ - size_;
+  }
+
   void
   init(void* buffer, size_t size){
     bufstart_ = reinterpret_cast<char*>(buffer);
@@ -69,7 +137,8 @@ class ser_buffer_accessor {
   ser_buffer_accessor() :
     bufstart_(0),
     bufptr_(0),
-    size_(0)
+    size_(0),
+    max_size_(0)
   {
   }
 
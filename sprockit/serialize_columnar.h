@@ -0,0 +1,293 @@
+#ifndef SERIALIZE_COLUMNAR_H
+#define SERIALIZE_COLUMNAR_H
+
+#include <sprockit/serializer.h>
+#include <sprockit/errors.h>
+
+#if SPKT_HAVE_CPP11
+#include <vector>
+#include <tuple>
+
+namespace sprockit {
+namespace pvt {
+
+template <class MemberPtr>
+struct ser_member_type;
+
+template <class Record, class Field>
+struct ser_member_type<Field Record::*> {
+  typedef Field type;
+};
+
+/**
+ * One field of every record, written contiguously
+ */
+template <class Record, class Field, bool primitive>
+class ser_record_column
+{
+ public:
+  void
+  operator()(std::vector<Record>& v, Field Record::* field, serializer& ser){
+    for (size_t i=0; i < v.size(); ++i){
+      serialize<Field>()(v[i].*field, ser);
+    }
+  }
+};
+
+template <class Record, class Field>
+class ser_record_column<Record,Field,true>
+{
+ public:
+  void
+  operator()(std::vector<Record>& v, Field Record::* field, serializer& ser){
+    size_t size = v.size();
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      ser.sizer().add(size * sizeof(Field));
+      break;
+    }
+    case serializer::PACK: {
+      ser_packer& packer = ser.packer();
+      packer.check_capacity(size, sizeof(Field));
+      for (size_t i=0; i < size; ++i){
+        packer.pack<Field,ser_trusted_policy>(v[i].*field);
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      ser_unpacker& unpacker = ser.unpacker();
+      unpacker.check_capacity(size, sizeof(Field));
+      for (size_t i=0; i < size; ++i){
+        unpacker.unpack<Field,ser_trusted_policy>(v[i].*field);
+      }
+      break;
+    }
+    case serializer::HASH: {
+      ser_hasher& hasher = ser.hasher();
+      for (size_t i=0; i < size; ++i){
+        hasher.hash(v[i].*field);
+      }
+      break;
+    }
+    case serializer::COPY_SOURCE: {
+      ser_copier& copier = ser.copier();
+      for (size_t i=0; i < size; ++i){
+        copier.record(v[i].*field);
+      }
+      break;
+    }
+    case serializer::COPY_DEST: {
+      ser_copier& copier = ser.copier();
+      for (size_t i=0; i < size; ++i){
+        copier.apply(v[i].*field);
+      }
+      break;
+    }
+    }
+  }
+};
+
+/**
+ * A column that is already a separate vector - no size prefix
+ */
+template <class T, bool primitive>
+class ser_vector_column
+{
+ public:
+  void
+  operator()(std::vector<T>& v, serializer& ser){
+    for (size_t i=0; i < v.size(); ++i){
+      serialize<T>()(v[i], ser);
+    }
+  }
+};
+
+template <class T>
+class ser_vector_column<T,true>
+{
+ public:
+  void
+  operator()(std::vector<T>& v, serializer& ser){
+    size_t size = v.size();
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      ser.sizer().add(size * sizeof(T));
+      break;
+    }
+    case serializer::PACK: {
+      if (size){
+        char* buf = ser.packer().next_str(size * sizeof(T));
+        ::memcpy(buf, &v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      if (size){
+        char* buf = ser.unpacker().next_str(size * sizeof(T));
+        ::memcpy(&v[0], buf, size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::HASH: {
+      if (size){
+        ser.hasher().add(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::COPY_SOURCE: {
+      if (size){
+        ser.copier().record_bytes(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::COPY_DEST: {
+      if (size){
+        ser.copier().apply_bytes(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    }
+  }
+};
+
+template <size_t N, class Record, class Fields>
+struct ser_record_columns
+{
+  static void
+  apply(std::vector<Record>& v, Fields& fields, serializer& ser){
+    ser_record_columns<N-1,Record,Fields>::apply(v, fields, ser);
+    typedef typename std::tuple_element<N-1,Fields>::type member_ptr;
+    ser_record_column<Record,
+      typename ser_member_type<member_ptr>::type,
+      ser_is_primitive<typename ser_member_type<member_ptr>::type>::value>()
+        (v, std::get<N-1>(fields), ser);
+  }
+};
+
+template <class Record, class Fields>
+struct ser_record_columns<0,Record,Fields>
+{
+  static void
+  apply(std::vector<Record>& v, Fields& fields, serializer& ser){}
+};
+
+template <size_t N, class Columns>
+struct ser_vector_columns
+{
+  static void
+  apply(Columns& cols, size_t size, serializer& ser){
+    ser_vector_columns<N-1,Columns>::apply(cols, size, ser);
+    typedef typename std::remove_reference<
+      typename std::tuple_element<N-1,Columns>::type>::type vector_t;
+    typedef typename vector_t::value_type T;
+    vector_t& v = std::get<N-1>(cols);
+    if (ser.mode() == serializer::UNPACK || ser.mode() == serializer::COPY_DEST){
+      v.resize(size);
+    } else if (v.size() != size){
+      spkt_throw_printf(value_error,
+        "serialize columns: column %d has %lu entries, expected %lu",
+        int(N-1), v.size(), size);
+    }
+    ser_vector_column<T,ser_is_primitive<T>::value>()(v, ser);
+  }
+};
+
+template <class Columns>
+struct ser_vector_columns<0,Columns>
+{
+  static void
+  apply(Columns& cols, size_t size, serializer& ser){}
+};
+
+template <class Record, class... Fields>
+class ser_columnar_wrapper
+{
+ public:
+  typedef std::tuple<Fields Record::*...> field_tuple;
+
+  std::vector<Record>& records;
+  field_tuple fields;
+
+  ser_columnar_wrapper(std::vector<Record>& v, Fields Record::*... f) :
+    records(v), fields(f...) {}
+};
+
+template <class... Ts>
+class ser_columns_wrapper
+{
+ public:
+  typedef std::tuple<std::vector<Ts>&...> column_tuple;
+
+  column_tuple columns;
+
+  ser_columns_wrapper(std::vector<Ts>&... v) :
+    columns(v...) {}
+};
+
+}
+
+/**
+ * Serialize a vector of records as one contiguous column per listed field,
+ * e.g. ser & columnar(links, &link::id, &link::bytes, &link::busy_time).
+ * Fields of primitive type are bounds-checked once per column.
+ * Fields not listed are not serialized.
+ * The wire format is the record count followed by each column in turn,
+ * so the result can also be unpacked with columns().
+ */
+template <class Record, class... Fields>
+pvt::ser_columnar_wrapper<Record,Fields...>
+columnar(std::vector<Record>& v, Fields Record::*... fields)
+{
+  return pvt::ser_columnar_wrapper<Record,Fields...>(v, fields...);
+}
+
+/**
+ * Serialize parallel vectors of equal length (a struct-of-arrays)
+ * in the same format as columnar(). Primitive columns are copied as
+ * single blocks, so a columnar() record vector can be decoded directly
+ * into separate arrays.
+ */
+template <class... Ts>
+pvt::ser_columns_wrapper<Ts...>
+columns(std::vector<Ts>&... v)
+{
+  return pvt::ser_columns_wrapper<Ts...>(v...);
+}
+
+template <class Record, class... Fields>
+inline void
+operator&(serializer& ser, pvt::ser_columnar_wrapper<Record,Fields...> col){
+  typedef typename pvt::ser_columnar_wrapper<Record,Fields...>::field_tuple field_tuple;
+  size_t size = col.records.size();
+  ser.primitive(size);
+  if (ser.mode() == serializer::UNPACK){
+    //every record takes at least a byte - reject a corrupt count before resizing
+    ser.unpacker().check_capacity(size);
+    col.records.resize(size);
+  } else if (ser.mode() == serializer::COPY_DEST){
+    col.records.resize(size);
+  }
+  pvt::ser_record_columns<sizeof...(Fields),Record,field_tuple>::apply(
+    col.records, col.fields, ser);
+}
+
+template <class... Ts>
+inline void
+operator&(serializer& ser, pvt::ser_columns_wrapper<Ts...> cols){
+  typedef typename pvt::ser_columns_wrapper<Ts...>::column_tuple column_tuple;
+  size_t size = std::get<0>(cols.columns).size();
+  ser.primitive(size);
+  if (ser.mode() == serializer::UNPACK){
+    ser.unpacker().check_capacity(size);
+  }
+  pvt::ser_vector_columns<sizeof...(Ts),column_tuple>::apply(
+    cols.columns, size, ser);
+}
+
+}
+
+#endif
+
+#endif // SERIALIZE_COLUMNAR_H
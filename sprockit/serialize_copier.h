@@ -0,0 +1,174 @@
+#ifndef SERIALIZE_COPIER_H
+#define SERIALIZE_COPIER_H
+
+#include <sprockit/errors.h>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <stdint.h>
+
+namespace sprockit {
+namespace pvt {
+
+/**
+ * The record a serializer in COPY_SOURCE mode leaves for COPY_DEST.
+ * Primitives are kept by value. Strings are moved into the destination by
+ * swap. Arrays and buffers are kept as pointers into the source and copied
+ * straight into the destination, so each byte is copied only once and no
+ * wire format is involved. The source must not change until the copy ends.
+ */
+class ser_copier
+{
+ public:
+  ser_copier() :
+    next_(0), size_(0)
+  {
+  }
+
+  template <class T>
+  void
+  record(const T& t){
+    entry e;
+    e.ptr = 0;
+    e.size = sizeof(T);
+    if (sizeof(T) <= sizeof(uint64_t)){
+      ::memcpy(&e.value, &t, sizeof(T));
+    } else {
+      //locals like container sizes are gone by the time the copy is applied
+      e.value = bytes_.size();
+      const char* ptr = reinterpret_cast<const char*>(&t);
+      bytes_.insert(bytes_.end(), ptr, ptr + sizeof(T));
+    }
+    entries_.push_back(e);
+    size_ += sizeof(T);
+  }
+
+  template <class T>
+  void
+  apply(T& t){
+    const entry& e = next(sizeof(T));
+    if (sizeof(T) <= sizeof(uint64_t)){
+      ::memcpy(&t, &e.value, sizeof(T));
+    } else {
+      ::memcpy(&t, &bytes_[e.value], sizeof(T));
+    }
+  }
+
+  void
+  record_bytes(const void* ptr, size_t size){
+    entry e;
+    e.value = 0;
+    e.ptr = ptr;
+    e.size = size;
+    entries_.push_back(e);
+    size_ += size;
+  }
+
+  void
+  apply_bytes(void* ptr, size_t size){
+    ::memcpy(ptr, next_bytes(size), size);
+  }
+
+  /**
+   * @return The source memory recorded with record_bytes
+   */
+  const void*
+  next_bytes(size_t size){
+    return next(size).ptr;
+  }
+
+  void
+  record_string(const std::string& str){
+    entry e;
+    e.value = strings_.size();
+    e.ptr = 0;
+    e.size = string_entry;
+    entries_.push_back(e);
+    strings_.push_back(str);
+    size_ += str.size();
+  }
+
+  void
+  apply_string(std::string& str){
+    const entry& e = next(string_entry);
+    str.swap(strings_[e.value]);
+  }
+
+  /**
+   * Start applying the record from the beginning
+   */
+  void
+  rewind(){
+    next_ = 0;
+    size_ = 0;
+  }
+
+  /**
+   * Throw if the destination did not consume everything the source recorded
+   */
+  void
+  finish() const {
+    if (next_ != entries_.size()){
+      spkt_throw_printf(value_error,
+        "serializer copy: destination consumed %lu of %lu source fields",
+        next_, entries_.size());
+    }
+  }
+
+  /**
+   * @return The number of bytes recorded or applied so far
+   */
+  size_t
+  size() const {
+    return size_;
+  }
+
+  void
+  reset(){
+    entries_.clear();
+    bytes_.clear();
+    strings_.clear();
+    next_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  static const size_t string_entry = ~size_t(0);
+
+  struct entry {
+    uint64_t value;
+    const void* ptr;
+    size_t size;
+  };
+
+  const entry&
+  next(size_t size){
+    if (next_ == entries_.size()){
+      spkt_throw_printf(value_error,
+        "serializer copy: destination reads past the %lu source fields",
+        entries_.size());
+    }
+    const entry& e = entries_[next_];
+    if (e.size != size){
+      spkt_throw_printf(value_error,
+        "serializer copy: field %lu has %lu bytes in the source, %lu in the destination",
+        next_, e.size, size);
+    }
+    ++next_;
+    if (size != string_entry) size_ += size;
+    return e;
+  }
+
+ private:
+  std::vector<entry> entries_;
+  std::vector<char> bytes_;
+  std::vector<std::string> strings_;
+  size_t next_;
+  size_t size_;
+
+};
+
+} }
+
+#endif // SERIALIZE_COPIER_H
@@ -0,0 +1,164 @@
+#ifndef SERIALIZE_DELTA_H
+#define SERIALIZE_DELTA_H
+
+#include <sprockit/serializer.h>
+#include <sprockit/preprocessor.h>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+
+namespace sprockit {
+namespace pvt {
+
+inline size_t
+varint_size(uint64_t x)
+{
+  size_t n = 1;
+  while (x >= 0x80){
+    x >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+inline void
+pack_varint(ser_packer& packer, uint64_t x)
+{
+  unsigned char tmp[10];
+  size_t n = 0;
+  while (x >= 0x80){
+    tmp[n++] = (unsigned char)(x | 0x80);
+    x >>= 7;
+  }
+  tmp[n++] = (unsigned char) x;
+  ::memcpy(packer.next_str(n), tmp, n);
+}
+
+inline uint64_t
+unpack_varint(ser_unpacker& unpacker)
+{
+  uint64_t x = 0;
+  int shift = 0;
+  unsigned char byte;
+  do {
+    byte = *unpacker.next<unsigned char>();
+    x |= uint64_t(byte & 0x7f) << shift;
+    shift += 7;
+  } while ((byte & 0x80) && shift < 64);
+  return x;
+}
+
+template <class Container>
+inline void
+delta_reserve(Container& c, size_t size){}
+
+template <class T>
+inline void
+delta_reserve(std::vector<T>& c, size_t size){
+  c.reserve(c.size() + size);
+}
+
+template <class Container>
+class ser_delta_wrapper
+{
+ public:
+  Container& container;
+  ser_delta_wrapper(Container& c) : container(c) {}
+};
+
+}
+
+/**
+ * Serialize a container of integers in ascending order (std::set, a sorted
+ * std::vector, ...) as a varint count followed by the varint-coded first value
+ * and differences between neighbors. Dense id sets mostly take one byte per
+ * element. Unsorted input still round-trips, just without the size benefit.
+ * This is a different wire format than ser & container, so both sides must
+ * use delta_coded().
+ */
+template <class Container>
+pvt::ser_delta_wrapper<Container>
+delta_coded(Container& c)
+{
+  return pvt::ser_delta_wrapper<Container>(c);
+}
+
+template <class Container>
+inline void
+operator&(serializer& ser, pvt::ser_delta_wrapper<Container> wrapper){
+  typedef typename Container::value_type T;
+  typedef typename Container::const_iterator iterator;
+#if SPKT_HAVE_CPP11
+  spkt_static_assert(std::numeric_limits<T>::is_integer,
+    "delta_coded() requires a container of integers");
+#endif
+  Container& c = wrapper.container;
+  //differences are taken modulo 2^64, which is exact for any integer type
+  switch(ser.mode())
+  {
+  case serializer::SIZER: {
+    size_t size = pvt::varint_size(c.size());
+    uint64_t prev = 0;
+    iterator it, end = c.end();
+    for (it=c.begin(); it != end; ++it){
+      uint64_t x = static_cast<uint64_t>(*it);
+      size += pvt::varint_size(x - prev);
+      prev = x;
+    }
+    ser.sizer().add(size);
+    break;
+  }
+  case serializer::PACK: {
+    pvt::ser_packer& packer = ser.packer();
+    pvt::pack_varint(packer, c.size());
+    uint64_t prev = 0;
+    iterator it, end = c.end();
+    for (it=c.begin(); it != end; ++it){
+      uint64_t x = static_cast<uint64_t>(*it);
+      pvt::pack_varint(packer, x - prev);
+      prev = x;
+    }
+    break;
+  }
+  case serializer::UNPACK: {
+    pvt::ser_unpacker& unpacker = ser.unpacker();
+    uint64_t size = pvt::unpack_varint(unpacker);
+    //every element takes at least a byte - reject a corrupt count before reserving
+    unpacker.check_capacity(size);
+    pvt::delta_reserve(c, size);
+    uint64_t prev = 0;
+    for (uint64_t i=0; i < size; ++i){
+      prev += pvt::unpack_varint(unpacker);
+      //ascending input makes the end hint exact, so set insertion is amortized O(1)
+      c.insert(c.end(), static_cast<T>(prev));
+    }
+    break;
+  }
+  case serializer::HASH:
+  case serializer::COPY_SOURCE: {
+    uint64_t size = c.size();
+    ser.primitive(size);
+    iterator it, end = c.end();
+    for (it=c.begin(); it != end; ++it){
+      uint64_t x = static_cast<uint64_t>(*it);
+      ser.primitive(x);
+    }
+    break;
+  }
+  case serializer::COPY_DEST: {
+    uint64_t size;
+    ser.primitive(size);
+    pvt::delta_reserve(c, size);
+    for (uint64_t i=0; i < size; ++i){
+      uint64_t x;
+      ser.primitive(x);
+      c.insert(c.end(), static_cast<T>(x));
+    }
+    break;
+  }
+  }
+}
+
+}
+
+#endif // SERIALIZE_DELTA_H
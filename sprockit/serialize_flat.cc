@@ -0,0 +1,215 @@
+#include <sprockit/serialize_flat.h>
+
+namespace sprockit {
+
+static inline size_t
+align_up(size_t size, size_t align)
+{
+  return (size + align - 1) & ~(align - 1);
+}
+
+/**
+ * @return The smallest power of two >= size, capped at the alignment
+ *         a table itself is guaranteed
+ */
+static inline size_t
+value_alignment(size_t size)
+{
+  size_t align = 1;
+  while (align < size && align < flat_builder::alignment) align <<= 1;
+  return align;
+}
+
+flat_builder::flat_builder(int nfields) :
+  nfields_(nfields)
+{
+  size_t header = align_up((nfields + 1) * sizeof(uint32_t), alignment);
+  buf_.resize(header, 0);
+  uint32_t n = nfields;
+  ::memcpy(&buf_[0], &n, sizeof(uint32_t));
+}
+
+char*
+flat_builder::reserve(int field, size_t size, size_t align)
+{
+  if (field < 0 || field >= nfields_){
+    spkt_throw_printf(value_error,
+      "flat_builder: field %d out of range for table with %d fields",
+      field, nfields_);
+  }
+  uint32_t* offsets = reinterpret_cast<uint32_t*>(&buf_[0]) + 1;
+  if (offsets[field] != 0){
+    spkt_throw_printf(value_error,
+      "flat_builder: field %d added twice", field);
+  }
+
+  size_t offset = align_up(buf_.size(), value_alignment(align));
+  if (offset + size > uint32_t(-1)){
+    spkt_throw_printf(value_error,
+      "flat_builder: table exceeds 4 GB");
+  }
+  buf_.resize(offset + size, 0);
+  //resize may have moved the buffer
+  offsets = reinterpret_cast<uint32_t*>(&buf_[0]) + 1;
+  offsets[field] = offset;
+  return &buf_[offset];
+}
+
+void
+flat_builder::add_string(int field, const std::string& str)
+{
+  add_array(field, str.data(), str.size());
+}
+
+void
+flat_builder::add_table(int field, const flat_builder& table)
+{
+  char* ptr = reserve(field, table.size(), alignment);
+  ::memcpy(ptr, table.data(), table.size());
+}
+
+flat_table::flat_table(const char* data, size_t size) :
+  data_(data), size_(size), nfields_(0)
+{
+  if (size_ < sizeof(uint32_t)){
+    spkt_throw_printf(value_error,
+      "flat_table: buffer of size %lu is too small for a table", size_);
+  }
+  uint32_t n = *reinterpret_cast<const uint32_t*>(data_);
+  check(0, (uint64_t(n) + 1) * sizeof(uint32_t));
+  nfields_ = n;
+}
+
+const char*
+flat_table::get_blob(int field, size_t elem_size, size_t& n) const
+{
+  uint32_t offset = field_offset(field);
+  if (offset == 0){
+    n = 0;
+    return 0;
+  }
+  check(offset, sizeof(uint64_t));
+  uint64_t len = *reinterpret_cast<const uint64_t*>(data_ + offset);
+  if (len > size_ / elem_size){
+    spkt_throw_printf(value_error,
+      "flat_table: field %d claims %lu elements in table of size %lu",
+      field, len, size_);
+  }
+  check(offset + sizeof(uint64_t), len * elem_size);
+  n = len;
+  return data_ + offset + sizeof(uint64_t);
+}
+
+flat_table
+flat_table::get_table(int field) const
+{
+  uint32_t offset = field_offset(field);
+  if (offset == 0){
+    return flat_table();
+  }
+  //the nested table's field count must lie inside this table
+  check(offset, sizeof(uint32_t));
+  return flat_table(data_ + offset, size_ - offset);
+}
+
+namespace pvt {
+
+size_t
+flat_table_padding(const char* pos)
+{
+  size_t table = size_t(pos) + 1 + sizeof(uint64_t);
+  return align_up(table, flat_builder::alignment) - table;
+}
+
+static void
+pack_flat(serializer& ser, const char* data, size_t size)
+{
+  switch(ser.mode())
+  {
+  case serializer::SIZER:
+    ser.sizer().add(flat_table_overhead + size);
+    break;
+  case serializer::PACK: {
+    char* ptr = ser.packer().next_str(flat_table_overhead + size);
+    uint8_t pad = flat_table_padding(ptr);
+    ::memset(ptr, 0, flat_table_overhead + size);
+    ptr[0] = pad;
+    uint64_t len = size;
+    ::memcpy(ptr + 1 + pad, &len, sizeof(uint64_t));
+    if (size) ::memcpy(ptr + 1 + pad + sizeof(uint64_t), data, size);
+    break;
+  }
+  case serializer::UNPACK:
+    spkt_throw_printf(illformed_error,
+      "flat_builder cannot be unpacked - unpack into a flat_table");
+    break;
+  case serializer::HASH: {
+    //padding depends on where the table lands in memory, so it is left out of the hash
+    uint64_t len = size;
+    ser.hasher().hash(len);
+    if (size) ser.hasher().add(data, size);
+    break;
+  }
+  case serializer::COPY_SOURCE: {
+    uint64_t len = size;
+    ser.copier().record(len);
+    if (size) ser.copier().record_bytes(data, size);
+    break;
+  }
+  case serializer::COPY_DEST:
+    spkt_throw_printf(illformed_error,
+      "flat_builder cannot be copied into - copy into a flat_table");
+    break;
+  }
+}
+
+}
+
+void
+operator&(serializer& ser, flat_builder& builder)
+{
+  pvt::pack_flat(ser, builder.data(), builder.size());
+}
+
+void
+operator&(serializer& ser, flat_table& table)
+{
+  if (ser.mode() == serializer::COPY_DEST){
+    //a table does not own its bytes, so the copy views the same ones as the source
+    uint64_t len;
+    ser.copier().apply(len);
+    if (len == 0){
+      table = flat_table();
+    } else {
+      const void* data = ser.copier().next_bytes(len);
+      table = flat_table(reinterpret_cast<const char*>(data), len);
+    }
+    return;
+  }
+
+  if (ser.mode() != serializer::UNPACK){
+    pvt::pack_flat(ser, table.data(), table.size());
+    return;
+  }
+
+  //the padding is read, not recomputed, so a table decodes the same
+  //wherever the unpack starts - e.g. in an indexed() worker
+  pvt::ser_unpacker& unpacker = ser.unpacker();
+  const char* header = unpacker.next_str(pvt::flat_table_overhead);
+  uint8_t pad = header[0];
+  if (pad >= flat_builder::alignment){
+    spkt_throw_printf(value_error,
+      "flat_table: corrupt padding %d", int(pad));
+  }
+  uint64_t len;
+  ::memcpy(&len, header + 1 + pad, sizeof(uint64_t));
+  unpacker.next_str(len);
+  const char* data = header + 1 + pad + sizeof(uint64_t);
+  if (len == 0){
+    table = flat_table();
+  } else {
+    table = flat_table(data, len);
+  }
+}
+
+}
@@ -0,0 +1,231 @@
+#ifndef SERIALIZE_FLAT_H
+#define SERIALIZE_FLAT_H
+
+#include <sprockit/serializer.h>
+#include <sprockit/errors.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace sprockit {
+
+/**
+ * Builds a relocatable table that can be read in place (see flat_table).
+ * Layout, all offsets relative to the start of the table:
+ *   uint32 nfields, uint32 field_offset[nfields] (0 = field absent),
+ *   then the field data, each value aligned to its size (see add).
+ * Strings and arrays are a uint64 length followed by the elements.
+ * Nested tables are copied in whole at an 8-byte boundary and,
+ * being relative, need no fixups. Fields may be added in any order
+ * and each field at most once.
+ */
+class flat_builder
+{
+ public:
+  static const size_t alignment = 8;
+
+  flat_builder(int nfields);
+
+  /**
+   * The value is aligned to sizeof(T) rounded up to a power of two,
+   * at most alignment
+   */
+  template <class T>
+  void
+  add(int field, const T& t){
+    char* ptr = reserve(field, sizeof(T), sizeof(T));
+    ::memcpy(ptr, &t, sizeof(T));
+  }
+
+  template <class T>
+  void
+  add_array(int field, const T* data, size_t n){
+    char* ptr = reserve(field, sizeof(uint64_t) + n*sizeof(T), alignment);
+    uint64_t len = n;
+    ::memcpy(ptr, &len, sizeof(uint64_t));
+    if (n) ::memcpy(ptr + sizeof(uint64_t), data, n*sizeof(T));
+  }
+
+  template <class T>
+  void
+  add_array(int field, const std::vector<T>& v){
+    add_array(field, v.empty() ? (const T*) 0 : &v[0], v.size());
+  }
+
+  void
+  add_string(int field, const std::string& str);
+
+  void
+  add_table(int field, const flat_builder& table);
+
+  const char*
+  data() const {
+    return &buf_[0];
+  }
+
+  size_t
+  size() const {
+    return buf_.size();
+  }
+
+ private:
+  char*
+  reserve(int field, size_t size, size_t align);
+
+ private:
+  std::vector<char> buf_;
+  int nfields_;
+
+};
+
+/**
+ * Zero-copy, zero-allocation reader for a buffer made by flat_builder.
+ * The table only points into the buffer, which must stay alive and be
+ * 8-byte aligned (any buffer from new/malloc/mmap or from ser & table is).
+ * Every access is bounds-checked against the table size.
+ */
+class flat_table
+{
+ public:
+  flat_table() :
+    data_(0), size_(0), nfields_(0)
+  {
+  }
+
+  flat_table(const char* data, size_t size);
+
+  bool
+  has(int field) const {
+    return field_offset(field) != 0;
+  }
+
+  int
+  nfields() const {
+    return nfields_;
+  }
+
+  template <class T>
+  T
+  get(int field, const T& def = T()) const {
+    uint32_t offset = field_offset(field);
+    if (offset == 0) return def;
+    check(offset, sizeof(T));
+    T t;
+    ::memcpy(&t, data_ + offset, sizeof(T));
+    return t;
+  }
+
+  /**
+   * @param n [out] The number of elements, 0 if the field is absent
+   * @return A pointer to the elements inside the buffer
+   */
+  template <class T>
+  const T*
+  get_array(int field, size_t& n) const {
+    const char* ptr = get_blob(field, sizeof(T), n);
+    return reinterpret_cast<const T*>(ptr);
+  }
+
+  /**
+   * @param len [out] The string length, 0 if the field is absent
+   * @return A pointer to the (not null-terminated) characters
+   */
+  const char*
+  get_string(int field, size_t& len) const {
+    return get_blob(field, 1, len);
+  }
+
+  std::string
+  get_string(int field) const {
+    size_t len;
+    const char* str = get_string(field, len);
+    return std::string(str, len);
+  }
+
+  flat_table
+  get_table(int field) const;
+
+  const char*
+  data() const {
+    return data_;
+  }
+
+  size_t
+  size() const {
+    return size_;
+  }
+
+ private:
+  uint32_t
+  field_offset(int field) const {
+    if (field < 0 || field >= nfields_) return 0;
+    return reinterpret_cast<const uint32_t*>(data_)[field+1];
+  }
+
+  void
+  check(uint64_t offset, uint64_t size) const {
+    if (offset + size > size_ || offset + size < offset){
+      spkt_throw_printf(value_error,
+        "flat_table: field at %lu of size %lu overruns table of size %lu",
+        offset, size, size_);
+    }
+  }
+
+  const char*
+  get_blob(int field, size_t elem_size, size_t& n) const;
+
+ private:
+  const char* data_;
+  size_t size_;
+  int nfields_;
+
+};
+
+namespace pvt {
+
+/**
+ * Flat tables are embedded in a stream as a uint8 pad count, pad zero
+ * bytes, a uint64 size, the table, and alignment - 1 - pad zero bytes.
+ * The pad puts the table at an 8-byte address in the packed buffer, so
+ * it is read in place from any receive buffer with the same alignment.
+ * Since the pad is stored, decoding does not depend on the stream
+ * position and the encoded size does not depend on the address.
+ */
+static const size_t flat_table_overhead =
+  1 + (flat_builder::alignment - 1) + sizeof(uint64_t);
+
+/**
+ * @param pos Where the embedded table's pad count will be written
+ * @return The pad that aligns the table that follows
+ */
+size_t
+flat_table_padding(const char* pos);
+
+}
+
+/**
+ * Pack a built table into a stream. Unpacking must go into a flat_table.
+ */
+void
+operator&(serializer& ser, flat_builder& builder);
+
+/**
+ * Unpacking leaves the table pointing into the receive buffer - no copy.
+ * Packing writes the table it points to, so a received table can be forwarded.
+ */
+void
+operator&(serializer& ser, flat_table& table);
+
+template <class T> class serialize;
+
+template <>
+class serialize<flat_table> {
+ public:
+  void operator()(flat_table& table, serializer& ser){
+    ser & table;
+  }
+};
+
+}
+
+#endif // SERIALIZE_FLAT_H
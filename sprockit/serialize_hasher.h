@@ -0,0 +1,109 @@
+#ifndef SERIALIZE_HASHER_H
+#define SERIALIZE_HASHER_H
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <stdint.h>
+
+namespace sprockit {
+namespace pvt {
+
+/**
+ * Streaming 64-bit hash (MurmurHash3-style mixing) fed one value at a time
+ * by a serializer in HASH mode. Each primitive is absorbed as one word,
+ * byte blocks eight bytes at a time, so nothing is ever buffered.
+ */
+class ser_hasher
+{
+ public:
+  ser_hasher(){
+    reset();
+  }
+
+  template <class T>
+  void
+  hash(T& t){
+    if (sizeof(T) <= sizeof(uint64_t)){
+      uint64_t k = 0;
+      ::memcpy(&k, &t, sizeof(T));
+      mix(k);
+      size_ += sizeof(T);
+    } else {
+      add(&t, sizeof(T));
+    }
+  }
+
+  void
+  add(const void* buf, size_t size){
+    const char* ptr = reinterpret_cast<const char*>(buf);
+    size_t nwords = size / sizeof(uint64_t);
+    for (size_t i=0; i < nwords; ++i, ptr += sizeof(uint64_t)){
+      uint64_t k;
+      ::memcpy(&k, ptr, sizeof(uint64_t));
+      mix(k);
+    }
+    size_t tail = size % sizeof(uint64_t);
+    //fold the length into the last word so different splits differ
+    uint64_t k = uint64_t(tail) << 56;
+    ::memcpy(&k, ptr, tail);
+    mix(k);
+    size_ += size;
+  }
+
+  void
+  hash_string(std::string& str){
+    int size = str.size();
+    hash(size);
+    add(str.data(), size);
+  }
+
+  uint64_t
+  digest() const {
+    uint64_t h = h_ ^ size_;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  /**
+   * @return The number of bytes absorbed
+   */
+  size_t
+  size() const {
+    return size_;
+  }
+
+  void
+  reset(uint64_t seed = 0){
+    h_ = seed ^ 0x9e3779b97f4a7c15ULL;
+    size_ = 0;
+  }
+
+ private:
+  static uint64_t
+  rotl(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+  }
+
+  void
+  mix(uint64_t k){
+    k *= 0x87c37b91114253d5ULL;
+    k = rotl(k, 31);
+    k *= 0x4cf5ad432745937fULL;
+    h_ ^= k;
+    h_ = rotl(h_, 27) * 5 + 0x52dce729;
+  }
+
+ private:
+  uint64_t h_;
+  size_t size_;
+
+};
+
+} }
+
+#endif // SERIALIZE_HASHER_H
@@ -0,0 +1,194 @@
+#ifndef SERIALIZE_INDEXED_H
+#define SERIALIZE_INDEXED_H
+
+#include <sprockit/serializer.h>
+#include <sprockit/errors.h>
+#include <vector>
+
+#if SPKT_HAVE_CPP11
+#include <thread>
+#include <exception>
+#endif
+
+namespace sprockit {
+namespace pvt {
+
+template <class T>
+class ser_indexed_wrapper
+{
+ public:
+  std::vector<T>& vec;
+  int nthreads;
+  ser_indexed_wrapper(std::vector<T>& v, int n) :
+    vec(v), nthreads(n) {}
+};
+
+template <class T>
+void
+unpack_indexed_range(std::vector<T>& v, char* data,
+                     const std::vector<size_t>& offsets,
+                     size_t begin, size_t end)
+{
+  serializer ser;
+  ser.start_unpacking(data + offsets[begin], offsets[end] - offsets[begin]);
+  for (size_t i=begin; i < end; ++i){
+    serialize<T>()(v[i], ser);
+  }
+}
+
+#if SPKT_HAVE_CPP11
+template <class T>
+void
+parallel_unpack_indexed(std::vector<T>& v, char* data,
+                        const std::vector<size_t>& offsets, int nthreads)
+{
+  size_t size = v.size();
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(nthreads);
+  //split by bytes rather than element count to balance variable-size elements
+  size_t total = offsets[size];
+  size_t begin = 0;
+  for (int t=0; t < nthreads; ++t){
+    size_t target = total / nthreads * (t+1);
+    size_t end = begin;
+    if (t == nthreads - 1){
+      end = size;
+    } else {
+      while (end < size && offsets[end] < target) ++end;
+    }
+    if (end > begin){
+      std::exception_ptr* err = &errors[t];
+      workers.push_back(std::thread([&v, data, &offsets, begin, end, err]{
+        try {
+          unpack_indexed_range(v, data, offsets, begin, end);
+        } catch (...) {
+          *err = std::current_exception();
+        }
+      }));
+    }
+    begin = end;
+  }
+  for (size_t t=0; t < workers.size(); ++t){
+    workers[t].join();
+  }
+  for (int t=0; t < nthreads; ++t){
+    if (errors[t]) std::rethrow_exception(errors[t]);
+  }
+}
+#endif
+
+}
+
+/**
+ * Serialize a vector preceded by an index of element offsets. Element
+ * boundaries are then known without decoding, so with C++11 the unpack
+ * can be split across nthreads worker threads. Worthwhile for large
+ * vectors of variable-size elements (checkpoints, tables of strings or
+ * nested containers). Unpacking falls back to a single thread if the
+ * serializer has an arena or a string table, since neither can be shared.
+ * Both sides must use indexed(); nthreads only matters for unpacking.
+ */
+template <class T>
+pvt::ser_indexed_wrapper<T>
+indexed(std::vector<T>& v, int nthreads = 1)
+{
+  return pvt::ser_indexed_wrapper<T>(v, nthreads);
+}
+
+template <class T>
+inline void
+operator&(serializer& ser, pvt::ser_indexed_wrapper<T> wrapper){
+  std::vector<T>& v = wrapper.vec;
+  switch(ser.mode())
+  {
+  case serializer::SIZER: {
+    size_t size = v.size();
+    ser.size(size);
+    ser.sizer().add((size + 1) * sizeof(size_t));
+    for (size_t i=0; i < size; ++i){
+      serialize<T>()(v[i], ser);
+    }
+    break;
+  }
+  case serializer::HASH:
+  case serializer::COPY_SOURCE: {
+    //the offset index is derived data - only the elements are hashed or copied
+    size_t size = v.size();
+    ser.primitive(size);
+    for (size_t i=0; i < size; ++i){
+      serialize<T>()(v[i], ser);
+    }
+    break;
+  }
+  case serializer::COPY_DEST: {
+    size_t size;
+    ser.primitive(size);
+    v.resize(size);
+    for (size_t i=0; i < size; ++i){
+      serialize<T>()(v[i], ser);
+    }
+    break;
+  }
+  case serializer::PACK: {
+    size_t size = v.size();
+    ser.pack(size);
+    pvt::ser_packer& packer = ser.packer();
+    std::vector<size_t> offsets(size + 1);
+    char* index = packer.next_str((size + 1) * sizeof(size_t));
+    size_t start = packer.size();
+    for (size_t i=0; i < size; ++i){
+      offsets[i] = packer.size() - start;
+      serialize<T>()(v[i], ser);
+    }
+    offsets[size] = packer.size() - start;
+    ::memcpy(index, &offsets[0], (size + 1) * sizeof(size_t));
+    break;
+  }
+  case serializer::UNPACK: {
+    size_t size;
+    ser.unpack(size);
+    pvt::ser_unpacker& unpacker = ser.unpacker();
+    //a corrupt count near SIZE_MAX would wrap size + 1 below
+    if (size >= unpacker.max_size() / sizeof(size_t)){
+      spkt_throw_printf(value_error,
+        "indexed container: corrupt element count %lu", size);
+    }
+    unpacker.check_capacity(size + 1, sizeof(size_t));
+    std::vector<size_t> offsets(size + 1);
+    char* index = unpacker.next_str((size + 1) * sizeof(size_t));
+    ::memcpy(&offsets[0], index, (size + 1) * sizeof(size_t));
+    for (size_t i=0; i < size; ++i){
+      if (offsets[i] > offsets[i+1]){
+        spkt_throw_printf(value_error,
+          "indexed container: corrupt offset %lu at element %lu",
+          offsets[i+1], i+1);
+      }
+    }
+    unpacker.check_capacity(offsets[size]);
+    v.resize(size);
+
+#if SPKT_HAVE_CPP11
+    if (wrapper.nthreads > 1 && size > 1
+        && unpacker.arena() == 0 && !ser.string_table_enabled()){
+      char* data = unpacker.next_str(offsets[size]);
+      pvt::parallel_unpack_indexed(v, data, offsets, wrapper.nthreads);
+      break;
+    }
+#endif
+    size_t start = unpacker.size();
+    for (size_t i=0; i < size; ++i){
+      serialize<T>()(v[i], ser);
+    }
+    if (unpacker.size() - start != offsets[size]){
+      spkt_throw_printf(value_error,
+        "indexed container: decoded %lu bytes, index says %lu",
+        unpacker.size() - start, offsets[size]);
+    }
+    break;
+  }
+  }
+}
+
+}
+
+#endif // SERIALIZE_INDEXED_H
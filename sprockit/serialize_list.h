@@ -9,43 +9,132 @@ namespace sprockit {
 
 namespace pvt {
 
-template <class Container, class T>
-void 
-serialize_container(Container& v, serializer& ser){
-  typedef typename Container::iterator iterator;
-  switch(ser.mode())
-  {
-  case serializer::SIZER: {
-    size_t size = v.size();
-    ser.size(size);
-    iterator it, end = v.end();
-    for (it=v.begin(); it != end; ++it){
-      T& t = *it;
-      serialize<T>()(t, ser);
+template <class Container, class T, bool primitive>
+class ser_container
+{
+ public:
+  void
+  operator()(Container& v, serializer& ser){
+    typedef typename Container::iterator iterator;
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      size_t size = v.size();
+      ser.size(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T& t = *it;
+        serialize<T>()(t, ser);
+      }
+      break;
     }
-    break;
-  }
-  case serializer::PACK: {
-    size_t size = v.size();
-    ser.pack(size);
-    iterator it, end = v.end();
-    for (it=v.begin(); it != end; ++it){
-      T& t = *it;
-      serialize<T>()(t, ser);
+    case serializer::HASH:
+    case serializer::COPY_SOURCE:
+    case serializer::PACK: {
+      size_t size = v.size();
+      ser.primitive(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T& t = *it;
+        serialize<T>()(t, ser);
+      }
+      break;
+    }
+    case serializer::COPY_DEST:
+    case serializer::UNPACK: {
+      size_t size;
+      ser.primitive(size);
+      for (int i=0; i < size; ++i){
+        T t;
+        serialize<T>()(t, ser);
+        v.push_back(t);
+      }
+      break;
     }
-    break;
-  }
-  case serializer::UNPACK: {
-    size_t size;
-    ser.unpack(size);
-    for (int i=0; i < size; ++i){
-      T t;
-      serialize<T>()(t, ser);
-      v.push_back(t);
     }
-    break;
   }
+};
+
+/**
+ * Same wire format, but the buffer is checked once for all elements
+ */
+template <class Container, class T>
+class ser_container<Container,T,true>
+{
+ public:
+  void
+  operator()(Container& v, serializer& ser){
+    typedef typename Container::iterator iterator;
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      size_t size = v.size();
+      ser.size(size);
+      ser.sizer().add(size * sizeof(T));
+      break;
+    }
+    case serializer::PACK: {
+      size_t size = v.size();
+      ser.pack(size);
+      ser_packer& packer = ser.packer();
+      packer.check_capacity(size, sizeof(T));
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        packer.pack<T,ser_trusted_policy>(*it);
+      }
+      break;
+    }
+    case serializer::HASH: {
+      size_t size = v.size();
+      ser_hasher& hasher = ser.hasher();
+      hasher.hash(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        hasher.hash(*it);
+      }
+      break;
+    }
+    case serializer::COPY_SOURCE: {
+      size_t size = v.size();
+      ser_copier& copier = ser.copier();
+      copier.record(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        copier.record(*it);
+      }
+      break;
+    }
+    case serializer::COPY_DEST: {
+      size_t size;
+      ser_copier& copier = ser.copier();
+      copier.apply(size);
+      for (size_t i=0; i < size; ++i){
+        T t;
+        copier.apply(t);
+        v.push_back(t);
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      size_t size;
+      ser.unpack(size);
+      ser_unpacker& unpacker = ser.unpacker();
+      unpacker.check_capacity(size, sizeof(T));
+      for (size_t i=0; i < size; ++i){
+        T t;
+        unpacker.unpack<T,ser_trusted_policy>(t);
+        v.push_back(t);
+      }
+      break;
+    }
+    }
   }
+};
+
+template <class Container, class T>
+void
+serialize_container(Container& v, serializer& ser){
+  ser_container<Container,T,ser_is_primitive<T>::value>()(v, ser);
 }
 
 }
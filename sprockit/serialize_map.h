@@ -27,9 +27,11 @@ serialize_map(Map& m, serializer& ser)
     }
     break;
   }
+  case serializer::HASH:
+  case serializer::COPY_SOURCE:
   case serializer::PACK: {
     size_t size = m.size();
-    ser.pack(size);
+    ser.primitive(size);
     iterator it, end = m.end();
     for (it=m.begin(); it != end; ++it){
       serialize<Key>()(const_cast<Key&>(it->first), ser);
@@ -37,9 +39,10 @@ serialize_map(Map& m, serializer& ser)
     }
     break;
   }
+  case serializer::COPY_DEST:
   case serializer::UNPACK: {
     size_t size;
-    ser.unpack(size);
+    ser.primitive(size);
     for (int i=0; i < size; ++i){
       Key k;
       Value v;
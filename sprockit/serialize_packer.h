@@ -18,6 +18,13 @@ class ser_packer :
     *buf = t;
   }
 
+  template <class T, class Policy>
+  void
+  pack(T& t){
+    T* buf = ser_buffer_accessor::next<T,Policy>();
+    *buf = t;
+  }
+
   void
   pack_buffer(void* buf, int size);
 
@@ -1,12 +1,11 @@
 #include <sprockit/ptr_type.h>
 #include <sprockit/spkt_string.h>
 #include <sprockit/serialize_serializable.h>
+#include <sprockit/serialize_stats.h>
 
 namespace sprockit {
 namespace pvt {
 
-static const long null_ptr_id = -1;
-
 void
 size_serializable(serializable* s, serializer& ser){
   long dummy = 0;
@@ -22,9 +21,11 @@ pack_serializable(serializable* s, serializer& ser){
     debug_printf(dbg::serialize,
       "object with class id %ld: %s",
       s->cls_id(), s->cls_name());
+    SPKT_SER_STATS_BEGIN(ser);
     long cls_id = s->cls_id();
     ser.pack(cls_id);
     s->serialize_order(ser);
+    SPKT_SER_STATS_PACK(ser, cls_id, s->cls_name());
   }
   else {
     debug_printf(dbg::serialize, "null object");
@@ -33,8 +34,39 @@ pack_serializable(serializable* s, serializer& ser){
   }
 }
 
+void
+hash_serializable(serializable* s, serializer& ser){
+  //the class id makes objects of different types with equal fields differ
+  long cls_id = s ? long(s->cls_id()) : null_ptr_id;
+  ser.hasher().hash(cls_id);
+  if (s) {
+    s->serialize_order(ser);
+  }
+}
+
+void
+copy_serializable(serializable*& s, serializer& ser){
+  if (ser.mode() == serializer::COPY_SOURCE){
+    long cls_id = s ? long(s->cls_id()) : null_ptr_id;
+    ser.primitive(cls_id);
+    if (s) {
+      s->serialize_order(ser);
+    }
+  } else {
+    long cls_id;
+    ser.copier().apply(cls_id);
+    if (cls_id == null_ptr_id) {
+      s = 0;
+    } else {
+      s = sprockit::serializable_factory::get_serializable(cls_id);
+      s->serialize_order(ser);
+    }
+  }
+}
+
 void
 unpack_serializable(serializable*& s, serializer& ser){
+  SPKT_SER_STATS_BEGIN(ser);
   long cls_id;
   ser.unpack(cls_id);
   if (cls_id == null_ptr_id) {
@@ -43,8 +75,9 @@ unpack_serializable(serializable*& s, serializer& ser){
   }
   else {
     debug_printf(dbg::serialize, "unpacking class id %ld", cls_id);
-    s = sprockit::serializable_factory::get_serializable(cls_id);
+    s = sprockit::serializable_factory::get_serializable(cls_id, ser.unpacker().arena());
     s->serialize_order(ser);
+    SPKT_SER_STATS_UNPACK(ser, cls_id, s->cls_name());
     debug_printf(dbg::serialize, "unpacked object %s", s->cls_name());
   }
 }
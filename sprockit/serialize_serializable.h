@@ -24,6 +24,16 @@ case serializer::UNPACK:
   pvt::unpack_serializable(s,ser);
   t = dynamic_cast<T*>(s);
   break;  
+case serializer::HASH:
+  pvt::hash_serializable(s,ser);
+  break;
+case serializer::COPY_SOURCE:
+  pvt::copy_serializable(s,ser);
+  break;
+case serializer::COPY_DEST:
+  pvt::copy_serializable(s,ser);
+  t = dynamic_cast<T*>(s);
+  break;
   }  
 }
 
@@ -9,43 +9,135 @@ namespace sprockit {
 
 namespace pvt {
 
-template <class Set, class T>
-void
-serialize_set(Set& v, serializer& ser) {
-  typedef typename Set::iterator iterator;
-  switch(ser.mode())
-  {
-  case serializer::SIZER: {
-    size_t size = v.size();
-    ser.size(size);
-    iterator it, end = v.end();
-    for (it=v.begin(); it != end; ++it){
-      T& t = const_cast<T&>(*it); 
-      serialize<T>()(t,ser);
+template <class Set, class T, bool primitive>
+class ser_set
+{
+ public:
+  void
+  operator()(Set& v, serializer& ser){
+    typedef typename Set::iterator iterator;
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      size_t size = v.size();
+      ser.size(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T& t = const_cast<T&>(*it); 
+        serialize<T>()(t,ser);
+      }
+      break;
     }
-    break;
-  }
-  case serializer::PACK: {
-    size_t size = v.size();
-    ser.pack(size);
-    iterator it, end = v.end();
-    for (it=v.begin(); it != end; ++it){
-      T& t = const_cast<T&>(*it); 
-      serialize<T>()(t,ser);
+    case serializer::HASH:
+    case serializer::COPY_SOURCE:
+    case serializer::PACK: {
+      size_t size = v.size();
+      ser.primitive(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T& t = const_cast<T&>(*it); 
+        serialize<T>()(t,ser);
+      }
+      break;
+    }
+    case serializer::COPY_DEST:
+    case serializer::UNPACK: {
+      size_t size;
+      ser.primitive(size);
+      for (int i=0; i < size; ++i){
+        T t;
+        serialize<T>()(t,ser);
+        v.insert(t);
+      }
+      break;
     }
-    break;
-  }
-  case serializer::UNPACK: {
-    size_t size;
-    ser.unpack(size);
-    for (int i=0; i < size; ++i){
-      T t;
-      serialize<T>()(t,ser);
-      v.insert(t);
     }
-    break;
   }
+};
+
+/**
+ * Same wire format, but the buffer is checked once for all elements
+ */
+template <class Set, class T>
+class ser_set<Set,T,true>
+{
+ public:
+  void
+  operator()(Set& v, serializer& ser){
+    typedef typename Set::iterator iterator;
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      size_t size = v.size();
+      ser.size(size);
+      ser.sizer().add(size * sizeof(T));
+      break;
+    }
+    case serializer::PACK: {
+      size_t size = v.size();
+      ser.pack(size);
+      ser_packer& packer = ser.packer();
+      packer.check_capacity(size, sizeof(T));
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T& t = const_cast<T&>(*it);
+        packer.pack<T,ser_trusted_policy>(t);
+      }
+      break;
+    }
+    case serializer::HASH: {
+      size_t size = v.size();
+      ser_hasher& hasher = ser.hasher();
+      hasher.hash(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        T t = *it;
+        hasher.hash(t);
+      }
+      break;
+    }
+    case serializer::COPY_SOURCE: {
+      size_t size = v.size();
+      ser_copier& copier = ser.copier();
+      copier.record(size);
+      iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        copier.record(*it);
+      }
+      break;
+    }
+    case serializer::COPY_DEST: {
+      size_t size;
+      ser_copier& copier = ser.copier();
+      copier.apply(size);
+      //for an ordered set the source order makes the end hint exact
+      for (size_t i=0; i < size; ++i){
+        T t;
+        copier.apply(t);
+        v.insert(v.end(), t);
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      size_t size;
+      ser.unpack(size);
+      ser_unpacker& unpacker = ser.unpacker();
+      unpacker.check_capacity(size, sizeof(T));
+      for (size_t i=0; i < size; ++i){
+        T t;
+        unpacker.unpack<T,ser_trusted_policy>(t);
+        v.insert(t);
+      }
+      break;
+    }
+    }
   }
+};
+
+template <class Set, class T>
+void
+serialize_set(Set& v, serializer& ser) {
+  ser_set<Set,T,ser_is_primitive<T>::value>()(v, ser);
 }
 
 } //end ns pvt
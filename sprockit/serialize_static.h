@@ -0,0 +1,351 @@
+#ifndef SERIALIZE_STATIC_H
+#define SERIALIZE_STATIC_H
+
+#include <sprockit/serialize.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <set>
+#include <map>
+
+/**
+ * Serializers with the mode fixed at compile time. A class writes its field
+ * list once as a template,
+ *
+ *   template <class Ser>
+ *   void serialize_order_t(Ser& ser){ ser & x_; ser & names_; ... }
+ *
+ * and gets its virtual serialize_order from ImplementStaticSerializeOrder().
+ * The mode is then switched on once per object instead of once per field,
+ * and every primitive compiles down to a plain store or load. The wire format
+ * is the same as for serializer. Fields with no static handling (serializable
+ * pointers, wrappers, types with a custom serialize<T>) go through the
+ * dynamic serializer underneath.
+ */
+
+namespace sprockit {
+
+class static_sizer
+{
+ public:
+  static const serializer::SERIALIZE_MODE mode = serializer::SIZER;
+
+  explicit static_sizer(serializer& ser) :
+    ser_(ser), sizer_(ser.sizer())
+  {
+  }
+
+  template <class T>
+  void
+  primitive(T& t){
+    sizer_.add(sizeof(T));
+  }
+
+  void
+  bytes(void* buf, size_t size){
+    sizer_.add(size);
+  }
+
+  void
+  string(std::string& str){
+    //through the serializer so a string table is sized as it is packed
+    ser_.string(str);
+  }
+
+  serializer&
+  dynamic(){
+    return ser_;
+  }
+
+ private:
+  serializer& ser_;
+  pvt::ser_sizer& sizer_;
+
+};
+
+template <class Policy = pvt::ser_default_policy>
+class static_packer
+{
+ public:
+  static const serializer::SERIALIZE_MODE mode = serializer::PACK;
+
+  explicit static_packer(serializer& ser) :
+    ser_(ser), packer_(ser.packer())
+  {
+  }
+
+  template <class T>
+  void
+  primitive(T& t){
+    packer_.pack<T,Policy>(t);
+  }
+
+  void
+  bytes(void* buf, size_t size){
+    ::memcpy(packer_.next_str<Policy>(size), buf, size);
+  }
+
+  void
+  string(std::string& str){
+    ser_.string(str);
+  }
+
+  serializer&
+  dynamic(){
+    return ser_;
+  }
+
+ private:
+  serializer& ser_;
+  pvt::ser_packer& packer_;
+
+};
+
+template <class Policy = pvt::ser_default_policy>
+class static_unpacker
+{
+ public:
+  static const serializer::SERIALIZE_MODE mode = serializer::UNPACK;
+
+  explicit static_unpacker(serializer& ser) :
+    ser_(ser), unpacker_(ser.unpacker())
+  {
+  }
+
+  template <class T>
+  void
+  primitive(T& t){
+    unpacker_.unpack<T,Policy>(t);
+  }
+
+  void
+  bytes(void* buf, size_t size){
+    ::memcpy(buf, unpacker_.next_str<Policy>(size), size);
+  }
+
+  void
+  string(std::string& str){
+    ser_.string(str);
+  }
+
+  serializer&
+  dynamic(){
+    return ser_;
+  }
+
+ private:
+  serializer& ser_;
+  pvt::ser_unpacker& unpacker_;
+
+};
+
+namespace pvt {
+
+template <class T, bool primitive = ser_is_primitive<T>::value>
+struct static_serialize {
+  template <class Ser>
+  static void
+  apply(T& t, Ser& ser){
+    ser.dynamic() & t;
+  }
+};
+
+template <class T>
+struct static_serialize<T,true> {
+  template <class Ser>
+  static void
+  apply(T& t, Ser& ser){
+    ser.primitive(t);
+  }
+};
+
+template <>
+struct static_serialize<bool,false> {
+  template <class Ser>
+  static void
+  apply(bool& t, Ser& ser){
+    int bval = t;
+    ser.primitive(bval);
+    t = bool(bval);
+  }
+};
+
+template <>
+struct static_serialize<std::string,false> {
+  template <class Ser>
+  static void
+  apply(std::string& t, Ser& ser){
+    ser.string(t);
+  }
+};
+
+template <class Ser>
+size_t
+static_container_size(Ser& ser, size_t size)
+{
+  ser.primitive(size);
+  return size;
+}
+
+template <class T>
+struct static_serialize<std::vector<T>,false> {
+  template <class Ser>
+  static void
+  apply(std::vector<T>& v, Ser& ser){
+    size_t size = static_container_size(ser, v.size());
+    if (Ser::mode == serializer::UNPACK){
+      if (ser_is_primitive<T>::value){
+        ser.dynamic().unpacker().check_capacity(size, sizeof(T));
+      }
+      v.resize(size);
+    }
+    if (ser_is_primitive<T>::value){
+      if (size) ser.bytes(&v[0], size * sizeof(T));
+    } else {
+      for (size_t i=0; i < size; ++i){
+        static_serialize<T>::apply(v[i], ser);
+      }
+    }
+  }
+};
+
+template <class Container, class T>
+struct static_sequence {
+  template <class Ser>
+  static void
+  apply(Container& v, Ser& ser){
+    size_t size = static_container_size(ser, v.size());
+    if (Ser::mode == serializer::UNPACK){
+      for (size_t i=0; i < size; ++i){
+        T t;
+        static_serialize<T>::apply(t, ser);
+        v.push_back(t);
+      }
+    } else {
+      typename Container::iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        static_serialize<T>::apply(*it, ser);
+      }
+    }
+  }
+};
+
+template <class T>
+struct static_serialize<std::list<T>,false> :
+  public static_sequence<std::list<T>,T> {};
+
+template <class T>
+struct static_serialize<std::deque<T>,false> :
+  public static_sequence<std::deque<T>,T> {};
+
+template <class T>
+struct static_serialize<std::set<T>,false> {
+  template <class Ser>
+  static void
+  apply(std::set<T>& v, Ser& ser){
+    size_t size = static_container_size(ser, v.size());
+    if (Ser::mode == serializer::UNPACK){
+      for (size_t i=0; i < size; ++i){
+        T t;
+        static_serialize<T>::apply(t, ser);
+        v.insert(v.end(), t);
+      }
+    } else {
+      typename std::set<T>::iterator it, end = v.end();
+      for (it=v.begin(); it != end; ++it){
+        static_serialize<T>::apply(const_cast<T&>(*it), ser);
+      }
+    }
+  }
+};
+
+template <class Key, class Value>
+struct static_serialize<std::map<Key,Value>,false> {
+  template <class Ser>
+  static void
+  apply(std::map<Key,Value>& m, Ser& ser){
+    size_t size = static_container_size(ser, m.size());
+    if (Ser::mode == serializer::UNPACK){
+      for (size_t i=0; i < size; ++i){
+        Key k;
+        static_serialize<Key>::apply(k, ser);
+        static_serialize<Value>::apply(m[k], ser);
+      }
+    } else {
+      typename std::map<Key,Value>::iterator it, end = m.end();
+      for (it=m.begin(); it != end; ++it){
+        static_serialize<Key>::apply(const_cast<Key&>(it->first), ser);
+        static_serialize<Value>::apply(it->second, ser);
+      }
+    }
+  }
+};
+
+}
+
+template <class T>
+inline static_sizer&
+operator&(static_sizer& ser, T& t){
+  pvt::static_serialize<T>::apply(t, ser);
+  return ser;
+}
+
+template <class Policy, class T>
+inline static_packer<Policy>&
+operator&(static_packer<Policy>& ser, T& t){
+  pvt::static_serialize<T>::apply(t, ser);
+  return ser;
+}
+
+template <class Policy, class T>
+inline static_unpacker<Policy>&
+operator&(static_unpacker<Policy>& ser, T& t){
+  pvt::static_serialize<T>::apply(t, ser);
+  return ser;
+}
+
+/**
+ * Switch on the mode once and run the templated serialize_order_t
+ * with the matching static serializer
+ */
+template <class T>
+void
+serialize_order_static(T& t, serializer& ser)
+{
+  switch(ser.mode())
+  {
+  case serializer::SIZER: {
+    static_sizer s(ser);
+    t.serialize_order_t(s);
+    break;
+  }
+  case serializer::PACK: {
+    static_packer<> s(ser);
+    t.serialize_order_t(s);
+    break;
+  }
+  case serializer::UNPACK: {
+    static_unpacker<> s(ser);
+    t.serialize_order_t(s);
+    break;
+  }
+  case serializer::HASH:
+  case serializer::COPY_SOURCE:
+  case serializer::COPY_DEST:
+    //not the packing hot path - run the fields through the dynamic serializer
+    t.serialize_order_t(ser);
+    break;
+  }
+}
+
+}
+
+#define ImplementStaticSerializeOrder() \
+ public: \
+  virtual void \
+  serialize_order(sprockit::serializer& ser){ \
+    sprockit::serialize_order_static(*this, ser); \
+  }
+
+#endif // SERIALIZE_STATIC_H
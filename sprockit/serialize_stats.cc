@@ -0,0 +1,216 @@
+#include <sprockit/serialize_stats.h>
+
+#if SPKT_SERIALIZE_STATS
+#include <sprockit/statics.h>
+#include <sprockit/spkt_string.h>
+#include <sprockit/unordered.h>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <map>
+#include <time.h>
+
+namespace sprockit {
+
+namespace pvt {
+
+typedef spkt_unordered_map<uint32_t, serialize_stats::entry> ser_stats_table;
+
+}
+
+//one table per thread, all of them also reachable from the global list
+static __thread pvt::ser_stats_table* local_table_ = 0;
+static std::vector<pvt::ser_stats_table*>* all_tables_ = 0;
+static int tables_lock_ = 0;
+
+//bumped by delete_statics, so every thread - not only the one that
+//freed the tables - knows its cached table pointer is gone
+static __thread int local_epoch_ = 0;
+static int tables_epoch_ = 0;
+
+static inline void
+lock_tables()
+{
+  while (__atomic_test_and_set(&tables_lock_, __ATOMIC_ACQUIRE)) ;
+}
+
+static inline void
+unlock_tables()
+{
+  __atomic_clear(&tables_lock_, __ATOMIC_RELEASE);
+}
+
+static pvt::ser_stats_table*
+thread_table()
+{
+  int epoch = __atomic_load_n(&tables_epoch_, __ATOMIC_ACQUIRE);
+  if (local_table_ == 0 || local_epoch_ != epoch){
+    local_table_ = new pvt::ser_stats_table;
+    local_epoch_ = epoch;
+    lock_tables();
+    if (all_tables_ == 0){
+      all_tables_ = new std::vector<pvt::ser_stats_table*>;
+      statics::register_finish(&serialize_stats::delete_statics);
+    }
+    all_tables_->push_back(local_table_);
+    unlock_tables();
+  }
+  return local_table_;
+}
+
+static serialize_stats::entry&
+thread_entry(uint32_t cls_id, const char* cls_name)
+{
+  pvt::ser_stats_table& table = *thread_table();
+  pvt::ser_stats_table::iterator it = table.find(cls_id);
+  if (it == table.end()){
+    serialize_stats::entry e;
+    ::memset(&e, 0, sizeof(e));
+    e.name = cls_name;
+    it = table.insert(std::make_pair(cls_id, e)).first;
+  }
+  return it->second;
+}
+
+static void
+add_entry(serialize_stats::entry& total, const serialize_stats::entry& e)
+{
+  total.name = e.name;
+  total.pack_count += e.pack_count;
+  total.pack_bytes += e.pack_bytes;
+  total.pack_ns += e.pack_ns;
+  total.unpack_count += e.unpack_count;
+  total.unpack_bytes += e.unpack_bytes;
+  total.unpack_ns += e.unpack_ns;
+}
+
+static void
+merge_tables(std::map<uint32_t, serialize_stats::entry>& merged)
+{
+  lock_tables();
+  if (all_tables_){
+    for (size_t i=0; i < all_tables_->size(); ++i){
+      pvt::ser_stats_table::const_iterator it, end = (*all_tables_)[i]->end();
+      for (it=(*all_tables_)[i]->begin(); it != end; ++it){
+        serialize_stats::entry& total = merged[it->first];
+        if (total.name == 0){
+          ::memset(&total, 0, sizeof(total));
+        }
+        add_entry(total, it->second);
+      }
+    }
+  }
+  unlock_tables();
+}
+
+static bool
+more_pack_bytes(const serialize_stats::entry& a, const serialize_stats::entry& b)
+{
+  return a.pack_bytes > b.pack_bytes;
+}
+
+uint64_t
+serialize_stats::now()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+serialize_stats::record_pack(uint32_t cls_id, const char* cls_name,
+                             size_t bytes, uint64_t ns)
+{
+  entry& e = thread_entry(cls_id, cls_name);
+  ++e.pack_count;
+  e.pack_bytes += bytes;
+  e.pack_ns += ns;
+}
+
+void
+serialize_stats::record_unpack(uint32_t cls_id, const char* cls_name,
+                               size_t bytes, uint64_t ns)
+{
+  entry& e = thread_entry(cls_id, cls_name);
+  ++e.unpack_count;
+  e.unpack_bytes += bytes;
+  e.unpack_ns += ns;
+}
+
+bool
+serialize_stats::totals(uint32_t cls_id, entry& e)
+{
+  std::map<uint32_t, entry> merged;
+  merge_tables(merged);
+  std::map<uint32_t, entry>::iterator it = merged.find(cls_id);
+  if (it == merged.end()){
+    return false;
+  }
+  e = it->second;
+  return true;
+}
+
+void
+serialize_stats::dump(std::ostream& os)
+{
+  std::map<uint32_t, entry> merged;
+  merge_tables(merged);
+  if (merged.empty()){
+    return;
+  }
+
+  std::vector<entry> sorted;
+  std::map<uint32_t, entry>::iterator it, end = merged.end();
+  for (it=merged.begin(); it != end; ++it){
+    sorted.push_back(it->second);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), more_pack_bytes);
+
+  os << sprockit::printf("%-32s %10s %14s %12s %10s %14s %12s\n",
+          "class", "packs", "pack bytes", "pack us",
+          "unpacks", "unpack bytes", "unpack us");
+  for (size_t i=0; i < sorted.size(); ++i){
+    const entry& e = sorted[i];
+    os << sprockit::printf("%-32s %10llu %14llu %12.1f %10llu %14llu %12.1f\n",
+          e.name,
+          (unsigned long long) e.pack_count,
+          (unsigned long long) e.pack_bytes,
+          e.pack_ns * 1e-3,
+          (unsigned long long) e.unpack_count,
+          (unsigned long long) e.unpack_bytes,
+          e.unpack_ns * 1e-3);
+  }
+}
+
+void
+serialize_stats::clear()
+{
+  lock_tables();
+  if (all_tables_){
+    for (size_t i=0; i < all_tables_->size(); ++i){
+      (*all_tables_)[i]->clear();
+    }
+  }
+  unlock_tables();
+}
+
+void
+serialize_stats::delete_statics()
+{
+  dump(std::cerr);
+  lock_tables();
+  if (all_tables_){
+    for (size_t i=0; i < all_tables_->size(); ++i){
+      delete (*all_tables_)[i];
+    }
+    delete all_tables_;
+    all_tables_ = 0;
+  }
+  local_table_ = 0;
+  __atomic_add_fetch(&tables_epoch_, 1, __ATOMIC_RELEASE);
+  unlock_tables();
+}
+
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef SERIALIZE_STATS_H
+#define SERIALIZE_STATS_H
+
+#include <sprockit/spkt_config.h>
+
+#if SPKT_SERIALIZE_STATS
+#include <iostream>
+#include <stdint.h>
+#include <cstddef>
+
+namespace sprockit {
+
+/**
+ * Per-class totals of serialized bytes, object counts, and time spent
+ * in pack_serializable/unpack_serializable. Each thread accumulates into
+ * its own table so recording never takes a lock. The tables are merged
+ * and dumped to std::cerr at statics::finish(), or on demand with dump().
+ * Bytes and time are inclusive of nested serializable objects.
+ * Only compiled in with --enable-serialize-stats.
+ */
+class serialize_stats
+{
+ public:
+  struct entry {
+    const char* name;
+    uint64_t pack_count;
+    uint64_t pack_bytes;
+    uint64_t pack_ns;
+    uint64_t unpack_count;
+    uint64_t unpack_bytes;
+    uint64_t unpack_ns;
+  };
+
+  static uint64_t
+  now();
+
+  static void
+  record_pack(uint32_t cls_id, const char* cls_name, size_t bytes, uint64_t ns);
+
+  static void
+  record_unpack(uint32_t cls_id, const char* cls_name, size_t bytes, uint64_t ns);
+
+  /**
+   * Merge the totals from all threads. Threads should not be
+   * serializing while this runs.
+   * @param cls_id
+   * @param e [out] The merged totals
+   * @return Whether anything has been recorded for the class
+   */
+  static bool
+  totals(uint32_t cls_id, entry& e);
+
+  /**
+   * Print the merged totals of all threads, largest packed bytes first.
+   * Threads should not be serializing while this runs.
+   */
+  static void
+  dump(std::ostream& os);
+
+  /**
+   * Zero all totals in all threads
+   */
+  static void
+  clear();
+
+  static void
+  delete_statics();
+
+};
+
+}
+
+#define SPKT_SER_STATS_BEGIN(ser) \
+  uint64_t spkt_ser_stats_t0_ = ::sprockit::serialize_stats::now(); \
+  size_t spkt_ser_stats_b0_ = (ser).size()
+
+#define SPKT_SER_STATS_PACK(ser, id, name) \
+  ::sprockit::serialize_stats::record_pack(id, name, \
+    (ser).size() - spkt_ser_stats_b0_, \
+    ::sprockit::serialize_stats::now() - spkt_ser_stats_t0_)
+
+#define SPKT_SER_STATS_UNPACK(ser, id, name) \
+  ::sprockit::serialize_stats::record_unpack(id, name, \
+    (ser).size() - spkt_ser_stats_b0_, \
+    ::sprockit::serialize_stats::now() - spkt_ser_stats_t0_)
+
+#else
+#define SPKT_SER_STATS_BEGIN(ser)
+#define SPKT_SER_STATS_PACK(ser, id, name)
+#define SPKT_SER_STATS_UNPACK(ser, id, name)
+#endif
+
+#endif // SERIALIZE_STATS_H
@@ -2,6 +2,7 @@
 #define SERIALIZE_UNPACKER_H
 
 #include <sprockit/serialize_buffer_accessor.h>
+#include <sprockit/serialize_arena.h>
 
 namespace sprockit {
 namespace pvt {
@@ -10,6 +11,11 @@ class ser_unpacker :
   public ser_buffer_accessor
 {
  public:
+  ser_unpacker() :
+    arena_(0)
+  {
+  }
+
   template <class T>
   void
   unpack(T& t){
@@ -17,12 +23,35 @@ class ser_unpacker :
     t = *bufptr;
   }
 
+  template <class T, class Policy>
+  void
+  unpack(T& t){
+    T* bufptr = ser_buffer_accessor::next<T,Policy>();
+    t = *bufptr;
+  }
+
   void
   unpack_buffer(void* buf, int size);
 
   void
   unpack_string(std::string& str);
 
+  /**
+   * @param arena If not null, unpacked objects and buffers are allocated here
+   */
+  void
+  set_arena(ser_arena* arena){
+    arena_ = arena;
+  }
+
+  ser_arena*
+  arena() const {
+    return arena_;
+  }
+
+ private:
+  ser_arena* arena_;
+
 };
 
 } }
@@ -6,8 +6,11 @@
 
 namespace sprockit {
 
-template <class T>
-class serialize<std::vector<T> > {
+namespace pvt {
+
+template <class T, bool primitive>
+class ser_vector
+{
   typedef std::vector<T> Vector; 
  public:
   void
@@ -19,14 +22,17 @@ class serialize<std::vector<T> > {
       ser.size(size);
       break;
     }
+    case serializer::HASH:
+    case serializer::COPY_SOURCE:
     case serializer::PACK: {
       size_t size = v.size();
-      ser.pack(size);
+      ser.primitive(size);
       break;
     }
+    case serializer::COPY_DEST:
     case serializer::UNPACK: {
       size_t s;
-      ser.unpack(s);
+      ser.primitive(s);
       v.resize(s);
       break;
     }
@@ -36,6 +42,87 @@ class serialize<std::vector<T> > {
       serialize<T>()(v[i], ser);
     }
   }
+};
+
+/**
+ * Same wire format, but the elements are copied as one block
+ */
+template <class T>
+class ser_vector<T,true>
+{
+  typedef std::vector<T> Vector; 
+ public:
+  void
+  operator()(Vector& v, serializer& ser) {
+    switch(ser.mode())
+    {
+    case serializer::SIZER: {
+      size_t size = v.size();
+      ser.size(size);
+      ser.sizer().add(size * sizeof(T));
+      break;
+    }
+    case serializer::PACK: {
+      size_t size = v.size();
+      ser.pack(size);
+      ser.packer().check_capacity(size, sizeof(T));
+      if (size){
+        char* buf = ser.packer().next_str<ser_trusted_policy>(size * sizeof(T));
+        ::memcpy(buf, &v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::UNPACK: {
+      size_t size;
+      ser.unpack(size);
+      //check before resizing so a corrupt size cannot trigger a huge allocation
+      ser.unpacker().check_capacity(size, sizeof(T));
+      v.resize(size);
+      if (size){
+        char* buf = ser.unpacker().next_str<ser_trusted_policy>(size * sizeof(T));
+        ::memcpy(&v[0], buf, size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::HASH: {
+      size_t size = v.size();
+      ser.hasher().hash(size);
+      if (size){
+        ser.hasher().add(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::COPY_SOURCE: {
+      size_t size = v.size();
+      ser.copier().record(size);
+      if (size){
+        ser.copier().record_bytes(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    case serializer::COPY_DEST: {
+      size_t size;
+      ser.copier().apply(size);
+      v.resize(size);
+      if (size){
+        ser.copier().apply_bytes(&v[0], size * sizeof(T));
+      }
+      break;
+    }
+    }
+  }
+};
+
+}
+
+template <class T>
+class serialize<std::vector<T> > {
+  typedef std::vector<T> Vector; 
+ public:
+  void
+  operator()(Vector& v, serializer& ser) {
+    pvt::ser_vector<T,pvt::ser_is_primitive<T>::value>()(v, ser);
+  }
   
 };
 
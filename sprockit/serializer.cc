@@ -26,7 +26,7 @@ ser_unpacker::unpack_buffer(void* buf, int size)
   if (size == 0){
     *bufptr = 0;
   } else {
-    *bufptr = new char[size];
+    *bufptr = arena_ ? arena_->allocate(size) : new char[size];
     char* charstr = next_str(size);
     ::memcpy(*bufptr, charstr, size);
   }
@@ -67,9 +67,61 @@ ser_sizer::size_string(std::string &str)
 
 } //end ns pvt
 
+void
+serializer::table_string(std::string& str)
+{
+  //a non-negative length introduces a new string,
+  //a negative length -(i+1) refers back to table entry i
+  switch(mode_)
+  {
+  case SIZER:
+  case PACK: {
+    //look up first so a repeated string is not copied into a new key
+    spkt_unordered_map<std::string,int>::iterator it = string_ids_.find(str);
+    if (it == string_ids_.end()){
+      int id = string_ids_.size();
+      string_ids_[str] = id;
+      if (mode_ == SIZER) sizer_.size_string(str);
+      else packer_.pack_string(str);
+    } else {
+      int ref = -(it->second + 1);
+      primitive(ref);
+    }
+    break;
+  }
+  case UNPACK: {
+    int size;
+    unpacker_.unpack(size);
+    if (size >= 0){
+      char* charstr = unpacker_.next_str(size);
+      strings_.push_back(std::string(charstr, size));
+      str = strings_.back();
+    } else {
+      size_t idx = -(size + 1);
+      if (idx >= strings_.size()){
+        spkt_throw_printf(value_error,
+          "serializer: string back-reference %lu with only %lu strings in table",
+          idx, strings_.size());
+      }
+      str = strings_[idx];
+    }
+    break;
+  }
+  default:
+    //only modes that produce or consume a stream use the table
+    break;
+  }
+}
+
 void
 serializer::string(std::string& str)
 {
+  //hashes and copies depend on content only, not on how the stream would encode it
+  if (use_string_table_ && (mode_ == SIZER || mode_ == PACK || mode_ == UNPACK)){
+    table_string(str);
+    return;
+  }
+
   switch(mode_)
   {
   case SIZER: {
@@ -84,6 +136,18 @@ serializer::string(std::string& str)
     unpacker_.unpack_string(str);
     break;
   }
+  case HASH: {
+    hasher_.hash_string(str);
+    break;
+  }
+  case COPY_SOURCE: {
+    copier_.record_string(str);
+    break;
+  }
+  case COPY_DEST: {
+    copier_.apply_string(str);
+    break;
+  }
   }
 }
 
@@ -16,6 +16,9 @@
 #include <sprockit/serialize_packer.h>
 #include <sprockit/serialize_sizer.h>
 #include <sprockit/serialize_unpacker.h>
+#include <sprockit/serialize_hasher.h>
+#include <sprockit/serialize_copier.h>
+#include <sprockit/unordered.h>
 #include <typeinfo>
 
 #include <cstring>
@@ -26,6 +29,39 @@
 
 namespace sprockit {
 
+namespace pvt {
+
+/**
+ * Types whose serialize<T> is a plain copy of sizeof(T) bytes.
+ * Containers of these check the buffer once for the whole run
+ * of elements instead of once per element.
+ */
+template <class T>
+struct ser_is_primitive {
+  static const bool value = false;
+};
+
+#define SPKT_SER_PRIMITIVE(type) \
+  template <> struct ser_is_primitive<type> { static const bool value = true; };
+
+SPKT_SER_PRIMITIVE(char)
+SPKT_SER_PRIMITIVE(signed char)
+SPKT_SER_PRIMITIVE(unsigned char)
+SPKT_SER_PRIMITIVE(short)
+SPKT_SER_PRIMITIVE(unsigned short)
+SPKT_SER_PRIMITIVE(int)
+SPKT_SER_PRIMITIVE(unsigned int)
+SPKT_SER_PRIMITIVE(long)
+SPKT_SER_PRIMITIVE(unsigned long)
+SPKT_SER_PRIMITIVE(long long)
+SPKT_SER_PRIMITIVE(unsigned long long)
+SPKT_SER_PRIMITIVE(float)
+SPKT_SER_PRIMITIVE(double)
+
+#undef SPKT_SER_PRIMITIVE
+
+}
+
 /**
   * This class is basically a wrapper for objects to declare the order in
   * which their members should be ser/des
@@ -34,12 +70,13 @@ class serializer
 {
  public:
   typedef enum {
-    SIZER, PACK, UNPACK
+    SIZER, PACK, UNPACK, HASH, COPY_SOURCE, COPY_DEST
   } SERIALIZE_MODE;
 
  public:
   serializer() :
-    mode_(SIZER) //just sizing by default
+    mode_(SIZER), //just sizing by default
+    use_string_table_(false)
   {
   }
 
@@ -57,6 +94,16 @@ class serializer
   sizer() {
     return sizer_;
   }
+
+  pvt::ser_hasher&
+  hasher() {
+    return hasher_;
+  }
+
+  pvt::ser_copier&
+  copier() {
+    return copier_;
+  }
   
   template <class T>
   void
@@ -95,6 +142,29 @@ class serializer
     sizer_.reset();
     packer_.reset();
     unpacker_.reset();
+    hasher_.reset();
+    copier_.reset();
+    clear_string_table();
+  }
+
+  /**
+   * With the string table enabled, each distinct string is written in full
+   * only the first time it occurs in a stream. Later copies are a
+   * back-reference to the earlier one, and unpacking decodes each distinct
+   * string only once. The table starts over with every start_sizing,
+   * start_packing and start_unpacking. This changes the wire format,
+   * so the packing and the unpacking side must agree on the setting.
+   */
+  void
+  enable_string_table(bool flag){
+    use_string_table_ = flag;
+    string_ids_.clear();
+    strings_.clear();
+  }
+
+  bool
+  string_table_enabled() const {
+    return use_string_table_;
   }
 
   template<typename T>
@@ -111,6 +181,15 @@ class serializer
     case UNPACK:
       unpacker_.unpack(t);
       break;
+    case HASH:
+      hasher_.hash(t);
+      break;
+    case COPY_SOURCE:
+      copier_.record(t);
+      break;
+    case COPY_DEST:
+      copier_.apply(t);
+      break;
     }
   }
   
@@ -133,6 +212,18 @@ class serializer
       ::memcpy(arr, charstr, N*sizeof(T));
       break;
     }   
+    case HASH: {
+      hasher_.add(arr, N*sizeof(T));
+      break;
+    }
+    case COPY_SOURCE: {
+      copier_.record_bytes(arr, N*sizeof(T));
+      break;
+    }
+    case COPY_DEST: {
+      copier_.apply_bytes(arr, N*sizeof(T));
+      break;
+    }
     }
   }
 
@@ -161,6 +252,29 @@ class serializer
       unpacker_.unpack_buffer(&buffer, size*sizeof(T));
       break;
     }
+    case HASH: {
+      Int sz = buffer ? size : Int(0);
+      hasher_.hash(sz);
+      if (sz) hasher_.add(buffer, sz*sizeof(T));
+      break;
+    }
+    case COPY_SOURCE: {
+      Int sz = buffer ? size : Int(0);
+      copier_.record(sz);
+      if (sz) copier_.record_bytes(buffer, sz*sizeof(T));
+      break;
+    }
+    case COPY_DEST: {
+      copier_.apply(size);
+      if (size){
+        char* copy = new char[size*sizeof(T)];
+        copier_.apply_bytes(copy, size*sizeof(T));
+        buffer = reinterpret_cast<T*>(copy);
+      } else {
+        buffer = 0;
+      }
+      break;
+    }
     }
   }
   
@@ -170,27 +284,87 @@ class serializer
   void
   start_packing(char* buffer, size_t size){
     packer_.init(buffer, size);
+    clear_string_table();
     mode_ = PACK;
   }
 
   void
   start_sizing(){
     sizer_.reset();
+    clear_string_table();
     mode_ = SIZER;
   }
 
+  /**
+   * @param buffer
+   * @param size
+   * @param arena If not null, all objects and binary buffers unpacked
+   *              from this buffer are allocated in the arena
+   */
   void
-  start_unpacking(char* buffer, size_t size){
+  start_unpacking(char* buffer, size_t size, ser_arena* arena = 0){
     unpacker_.init(buffer, size);
+    unpacker_.set_arena(arena);
+    clear_string_table();
     mode_ = UNPACK;
   }
 
+  /**
+   * Stream every value through a 64-bit hash instead of a buffer.
+   * Running an object through the serializer then gives digest(), a content
+   * fingerprint, for one traversal and no allocation.
+   */
+  void
+  start_hashing(uint64_t seed = 0){
+    hasher_.reset(seed);
+    mode_ = HASH;
+  }
+
+  uint64_t
+  digest() const {
+    return hasher_.digest();
+  }
+
+  /**
+   * A deep copy is two passes over serialize_order: the source object
+   * is walked in COPY_SOURCE mode, recording its fields, and then a fresh
+   * destination is walked in COPY_DEST mode, which fills it in and builds
+   * subobjects through the serializable factory. See deep_copy().
+   */
+  void
+  start_copy_source(){
+    copier_.reset();
+    mode_ = COPY_SOURCE;
+  }
+
+  void
+  start_copy_dest(){
+    copier_.rewind();
+    mode_ = COPY_DEST;
+  }
+
   size_t
   size() const {
     switch (mode_){
       case SIZER: return sizer_.size();
       case PACK: return packer_.size();
       case UNPACK: return unpacker_.size();
+      case HASH: return hasher_.size();
+      case COPY_SOURCE:
+      case COPY_DEST: return copier_.size();
+    }
+    return 0;
+  }
+
+ protected:
+  void
+  table_string(std::string& str);
+
+  void
+  clear_string_table(){
+    if (use_string_table_){
+      string_ids_.clear();
+      strings_.clear();
     }
   }
 
@@ -200,8 +374,16 @@ class serializer
   pvt::ser_packer packer_;
   pvt::ser_unpacker unpacker_;
   pvt::ser_sizer sizer_;
+  pvt::ser_hasher hasher_;
+  pvt::ser_copier copier_;
   SERIALIZE_MODE mode_;
 
+  bool use_string_table_;
+  //sizing and packing: index of each string already written
+  spkt_unordered_map<std::string, int> string_ids_;
+  //unpacking: each string in the order it was first read
+  std::vector<std::string> strings_;
+
 };
 
 } // end of namespace sprockit
@@ -0,0 +1,297 @@
+#include <sprockit/shm_ring.h>
+#include <sprockit/errors.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <sched.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace sprockit {
+
+static const uint64_t shm_ring_magic = 0x73706b7472696e67ULL; //"spktring"
+static const uint64_t wrap_marker = ~uint64_t(0);
+static const int num_spins_before_sleep = 128;
+
+static inline void
+futex_wait(uint32_t* addr, uint32_t val)
+{
+#ifdef __linux__
+  //not FUTEX_PRIVATE - the word lives in memory shared between processes
+  ::syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+#else
+  sched_yield();
+#endif
+}
+
+static inline void
+futex_wake(uint32_t* addr)
+{
+#ifdef __linux__
+  ::syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+static inline size_t
+round_up8(size_t size)
+{
+  return (size + 7) & ~size_t(7);
+}
+
+shm_ring::shm_ring(const std::string& name, size_t capacity) :
+  name_(name),
+  header_(0),
+  data_(0),
+  capacity_(round_up8(capacity)),
+  mapped_size_(0),
+  owner_(true),
+  pending_head_(0),
+  pending_tail_(0),
+  seen_tail_(0)
+{
+  int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0){
+    spkt_throw_printf(os_error,
+      "shm_ring: failed creating segment %s: %s",
+      name_.c_str(), ::strerror(errno));
+  }
+
+  size_t total_size = sizeof(pvt::shm_ring_header) + capacity_;
+  if (::ftruncate(fd, total_size) != 0){
+    int err = errno;
+    ::close(fd);
+    ::shm_unlink(name_.c_str());
+    spkt_throw_printf(os_error,
+      "shm_ring: failed sizing segment %s to %lu bytes: %s",
+      name_.c_str(), total_size, ::strerror(err));
+  }
+
+  map_segment(fd, total_size);
+
+  ::memset(header_, 0, sizeof(pvt::shm_ring_header));
+  header_->capacity = capacity_;
+  //publish the magic last so attaching processes see an initialized header
+  __atomic_store_n(&header_->magic, shm_ring_magic, __ATOMIC_RELEASE);
+}
+
+shm_ring::shm_ring(const std::string& name) :
+  name_(name),
+  header_(0),
+  data_(0),
+  capacity_(0),
+  mapped_size_(0),
+  owner_(false),
+  pending_head_(0),
+  pending_tail_(0),
+  seen_tail_(0)
+{
+  int fd = ::shm_open(name_.c_str(), O_RDWR, 0600);
+  if (fd < 0){
+    spkt_throw_printf(os_error,
+      "shm_ring: failed attaching segment %s: %s",
+      name_.c_str(), ::strerror(errno));
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(pvt::shm_ring_header)){
+    ::close(fd);
+    spkt_throw_printf(os_error,
+      "shm_ring: segment %s is not a valid ring",
+      name_.c_str());
+  }
+
+  map_segment(fd, st.st_size);
+
+  if (__atomic_load_n(&header_->magic, __ATOMIC_ACQUIRE) != shm_ring_magic){
+    ::munmap(header_, mapped_size_);
+    spkt_throw_printf(value_error,
+      "shm_ring: segment %s has not been initialized as a ring",
+      name_.c_str());
+  }
+  capacity_ = header_->capacity;
+  if (capacity_ > mapped_size_ - sizeof(pvt::shm_ring_header)){
+    ::munmap(header_, mapped_size_);
+    spkt_throw_printf(value_error,
+      "shm_ring: segment %s holds %lu bytes, too small for a %lu byte ring",
+      name_.c_str(), mapped_size_, capacity_);
+  }
+}
+
+shm_ring::~shm_ring()
+{
+  if (header_){
+    ::munmap(header_, mapped_size_);
+  }
+  if (owner_){
+    ::shm_unlink(name_.c_str());
+  }
+}
+
+void
+shm_ring::map_segment(int fd, size_t total_size)
+{
+  void* ptr = ::mmap(0, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (ptr == MAP_FAILED){
+    if (owner_) ::shm_unlink(name_.c_str());
+    spkt_throw_printf(memory_error,
+      "shm_ring: failed mapping segment %s: %s",
+      name_.c_str(), ::strerror(err));
+  }
+  mapped_size_ = total_size;
+  header_ = reinterpret_cast<pvt::shm_ring_header*>(ptr);
+  data_ = reinterpret_cast<char*>(ptr) + sizeof(pvt::shm_ring_header);
+}
+
+uint64_t
+shm_ring::record_size(size_t size) const
+{
+  return sizeof(uint64_t) + round_up8(size);
+}
+
+bool
+shm_ring::space_available(size_t size, uint64_t& total)
+{
+  total = record_size(size);
+  //anything larger could need more than the free space even in an empty ring
+  //once the wrap padding is accounted for
+  if (total > capacity_ / 2){
+    spkt_throw_printf(value_error,
+      "shm_ring: record of size %lu exceeds half the capacity %lu of ring %s",
+      size, capacity_, name_.c_str());
+  }
+
+  uint64_t head = header_->head; //only the producer writes head
+  uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_ACQUIRE);
+  seen_tail_ = tail;
+  uint64_t offset = head % capacity_;
+  uint64_t contiguous = capacity_ - offset;
+  if (contiguous < total){
+    //pad out the end of the ring and start over at the front
+    total += contiguous;
+  }
+  return (head + total - tail) <= capacity_;
+}
+
+bool
+shm_ring::try_reserve(size_t size, char*& buf)
+{
+  uint64_t total;
+  if (!space_available(size, total)){
+    return false;
+  }
+
+  uint64_t head = header_->head;
+  uint64_t offset = head % capacity_;
+  if (total > record_size(size)){
+    *reinterpret_cast<uint64_t*>(data_ + offset) = wrap_marker;
+    offset = 0;
+  }
+  *reinterpret_cast<uint64_t*>(data_ + offset) = size;
+  buf = data_ + offset + sizeof(uint64_t);
+  pending_head_ = head + total;
+  return true;
+}
+
+char*
+shm_ring::reserve(size_t size)
+{
+  char* buf;
+  int spins = 0;
+  while (!try_reserve(size, buf)){
+    if (++spins > num_spins_before_sleep){
+      wait_for_space();
+    }
+  }
+  return buf;
+}
+
+void
+shm_ring::commit()
+{
+  __atomic_store_n(&header_->head, pending_head_, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&header_->consumer_waiting, __ATOMIC_SEQ_CST)){
+    __atomic_add_fetch(&header_->data_signal, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&header_->data_signal);
+  }
+}
+
+bool
+shm_ring::try_peek(char*& buf, size_t& size)
+{
+  uint64_t tail = header_->tail; //only the consumer writes tail
+  uint64_t head = __atomic_load_n(&header_->head, __ATOMIC_ACQUIRE);
+  if (tail == head){
+    return false;
+  }
+
+  uint64_t offset = tail % capacity_;
+  uint64_t length = *reinterpret_cast<uint64_t*>(data_ + offset);
+  if (length == wrap_marker){
+    //the producer always commits the wrap marker together with a record
+    tail += capacity_ - offset;
+    offset = 0;
+    length = *reinterpret_cast<uint64_t*>(data_);
+  }
+  buf = data_ + offset + sizeof(uint64_t);
+  size = length;
+  pending_tail_ = tail + record_size(length);
+  return true;
+}
+
+void
+shm_ring::peek(char*& buf, size_t& size)
+{
+  int spins = 0;
+  while (!try_peek(buf, size)){
+    if (++spins > num_spins_before_sleep){
+      wait_for_data();
+    }
+  }
+}
+
+void
+shm_ring::release()
+{
+  __atomic_store_n(&header_->tail, pending_tail_, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&header_->producer_waiting, __ATOMIC_SEQ_CST)){
+    __atomic_add_fetch(&header_->space_signal, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&header_->space_signal);
+  }
+}
+
+void
+shm_ring::wait_for_data()
+{
+  uint32_t signal = __atomic_load_n(&header_->data_signal, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&header_->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+  //recheck after advertising - the producer might have committed in between
+  uint64_t head = __atomic_load_n(&header_->head, __ATOMIC_SEQ_CST);
+  if (head == header_->tail){
+    futex_wait(&header_->data_signal, signal);
+  }
+  __atomic_store_n(&header_->consumer_waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+void
+shm_ring::wait_for_space()
+{
+  uint32_t signal = __atomic_load_n(&header_->space_signal, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&header_->producer_waiting, 1, __ATOMIC_SEQ_CST);
+  //recheck after advertising - the consumer might have released in between
+  uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_SEQ_CST);
+  if (tail == seen_tail_){
+    futex_wait(&header_->space_signal, signal);
+  }
+  __atomic_store_n(&header_->producer_waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+}
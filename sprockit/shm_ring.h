@@ -0,0 +1,189 @@
+#ifndef SPROCKIT_SHM_RING_H
+#define SPROCKIT_SHM_RING_H
+
+#include <sprockit/serialize.h>
+#include <string>
+#include <stdint.h>
+
+namespace sprockit {
+
+namespace pvt {
+
+/**
+ * Control block at the front of the shared segment. Producer and consumer
+ * indices sit on their own cache lines so the two sides never false-share.
+ * Indices are monotonically increasing byte counts, taken modulo capacity.
+ */
+struct shm_ring_header
+{
+  uint64_t magic;
+  uint64_t capacity;
+  char pad0[48];
+
+  uint64_t head; //bytes committed by producer
+  uint32_t data_signal; //futex word bumped when new data is committed
+  uint32_t consumer_waiting;
+  char pad1[48];
+
+  uint64_t tail; //bytes released by consumer
+  uint32_t space_signal; //futex word bumped when space is released
+  uint32_t producer_waiting;
+  char pad2[48];
+};
+
+}
+
+/**
+ * A single-producer/single-consumer ring of variable-length records
+ * living in a POSIX shared-memory segment. Processes on the same node
+ * pack directly into the ring and the receiver unpacks in place,
+ * so no intermediate buffer or copy is needed for the handoff.
+ * Each record is an 8-byte length followed by the payload, padded
+ * to 8 bytes. A record that would straddle the end of the ring is
+ * preceded by a wrap marker and written at the front instead.
+ * A single record may therefore be at most half the ring capacity.
+ */
+class shm_ring
+{
+ public:
+  /**
+   * Create (and own) a new shared segment. The segment is unlinked
+   * when the creating object is destroyed.
+   * @param name  A POSIX shm name, e.g. "/my_ring"
+   * @param capacity The number of payload bytes in the ring
+   */
+  shm_ring(const std::string& name, size_t capacity);
+
+  /**
+   * Attach to a segment previously created by another shm_ring
+   * @param name  A POSIX shm name, e.g. "/my_ring"
+   */
+  shm_ring(const std::string& name);
+
+  ~shm_ring();
+
+  /**
+   * Reserve contiguous space for the next record, blocking until the
+   * consumer has released enough of the ring.
+   * @param size The payload size in bytes
+   * @return Pointer into the shared segment to write the record into
+   */
+  char*
+  reserve(size_t size);
+
+  /**
+   * @param size The payload size in bytes
+   * @param buf [out] Pointer to write the record into if space was available
+   * @return Whether space was available
+   */
+  bool
+  try_reserve(size_t size, char*& buf);
+
+  /**
+   * Publish the most recently reserved record to the consumer
+   */
+  void
+  commit();
+
+  /**
+   * Block until a record is available
+   * @param buf [out] Pointer to the record payload inside the segment
+   * @param size [out] The payload size in bytes
+   */
+  void
+  peek(char*& buf, size_t& size);
+
+  /**
+   * @param buf [out] Pointer to the record payload inside the segment
+   * @param size [out] The payload size in bytes
+   * @return Whether a record was available
+   */
+  bool
+  try_peek(char*& buf, size_t& size);
+
+  /**
+   * Hand the most recently peeked record back to the producer
+   */
+  void
+  release();
+
+  size_t
+  capacity() const {
+    return capacity_;
+  }
+
+  const std::string&
+  name() const {
+    return name_;
+  }
+
+  /**
+   * Size, pack, and publish an object as a single record
+   */
+  template <class T>
+  void
+  send(T& t){
+    serializer ser;
+    ser.start_sizing();
+    ser & t;
+    size_t size = ser.size();
+    char* buf = reserve(size);
+    ser.start_packing(buf, size);
+    ser & t;
+    commit();
+  }
+
+  /**
+   * Wait for the next record and unpack it in place
+   */
+  template <class T>
+  void
+  recv(T& t){
+    char* buf;
+    size_t size;
+    peek(buf, size);
+    serializer ser;
+    ser.start_unpacking(buf, size);
+    try {
+      ser & t;
+    } catch (...) {
+      //drop the bad record rather than wedge the ring behind it
+      release();
+      throw;
+    }
+    release();
+  }
+
+ private:
+  void
+  map_segment(int fd, size_t total_size);
+
+  uint64_t
+  record_size(size_t size) const;
+
+  bool
+  space_available(size_t size, uint64_t& total);
+
+  void
+  wait_for_space();
+
+  void
+  wait_for_data();
+
+ private:
+  std::string name_;
+  pvt::shm_ring_header* header_;
+  char* data_;
+  size_t capacity_;
+  size_t mapped_size_;
+  bool owner_;
+
+  uint64_t pending_head_;
+  uint64_t pending_tail_;
+  uint64_t seen_tail_;
+
+};
+
+}
+
+#endif // SPROCKIT_SHM_RING_H
@@ -13,6 +13,8 @@
 #include <sprockit/spkt_config.h>
 #include <sprockit/spkt_string.h>
 #include <sprockit/sim_parameters.h>
+#include <sprockit/param_image.h>
+#include <sprockit/param_include_graph.h>
 #include <sprockit/basic_string_tokenizer.h>
 #include <sprockit/units.h>
 #include <sprockit/driver_util.h>
@@ -21,7 +23,14 @@
 #include <sprockit/regexp.h>
 #include <sprockit/fileio.h>
 #include <sprockit/output.h>
+#include <sprockit/serialize.h>
+#include <sprockit/serialize_string.h>
 #include <cstring>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 RegisterDebugSlot(params,
     "print all the details of the initial reading parameters from the input file"
@@ -64,6 +73,124 @@ get_quantity_with_units(const char* value, const char* key)
 }
 
 sim_parameters* sim_parameters::empty_ns_params_ = new sim_parameters;
+unsigned long sim_parameters::generation_ = 0;
+const uint32_t sim_parameters::image_version;
+
+//"SPKTPIMG"
+static const uint64_t image_magic = 0x474d49505450534bULL;
+
+struct image_source {
+  std::string path;
+  uint64_t size;
+  int64_t mtime;
+  uint64_t hash;
+};
+
+static bool
+stat_source(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0){
+    return false;
+  }
+  size = st.st_size;
+#if SPKT_HAVE_STRUCT_STAT_ST_MTIM
+  mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#elif SPKT_HAVE_STRUCT_STAT_ST_MTIMESPEC
+  mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  //the content hash still catches changes within the same second
+  mtime = int64_t(st.st_mtime) * 1000000000;
+#endif
+  return true;
+}
+
+static uint64_t
+hash_source(const std::string& path)
+{
+  mapped_file file;
+  if (!file.open(path)){
+    return 0;
+  }
+  pvt::ser_hasher hasher;
+  hasher.add(file.contents().data(), file.contents().size());
+  return hasher.digest();
+}
+
+static void
+serialize_sources(serializer& ser, std::vector<image_source>& sources)
+{
+  uint32_t nsources = sources.size();
+  ser & nsources;
+  sources.resize(nsources);
+  for (uint32_t i=0; i < nsources; ++i){
+    image_source& src = sources[i];
+    ser & src.path;
+    ser & src.size;
+    ser & src.mtime;
+    ser & src.hash;
+  }
+}
+
+//Images come from disk, so they are bounds checked even in a build
+//configured with --enable-trusted-serialization. A short or corrupt
+//image throws pvt::ser_buffer_overrun instead of reading past the end.
+typedef pvt::ser_checked_policy image_policy;
+
+template <class T>
+static void
+unpack_checked(serializer& ser, T& t)
+{
+  ser.unpacker().unpack<T,image_policy>(t);
+}
+
+static void
+unpack_checked(serializer& ser, std::string& str)
+{
+  int size;
+  unpack_checked(ser, size);
+  //a negative size converts to one larger than any buffer
+  char* charstr = ser.unpacker().next_str<image_policy>(size_t(size));
+  str.assign(charstr, size);
+}
+
+/**
+ * @param count A count just read from an image
+ * @param min_size The fewest bytes each counted item occupies
+ */
+static void
+check_image_count(serializer& ser, uint32_t count, size_t min_size)
+{
+  ser.unpacker().check_capacity<image_policy>(count, min_size);
+}
+
+static void
+unpack_sources(serializer& ser, std::vector<image_source>& sources)
+{
+  uint32_t nsources;
+  unpack_checked(ser, nsources);
+  check_image_count(ser, nsources, sizeof(int) + 3*sizeof(uint64_t));
+  sources.resize(nsources);
+  for (uint32_t i=0; i < nsources; ++i){
+    image_source& src = sources[i];
+    unpack_checked(ser, src.path);
+    unpack_checked(ser, src.size);
+    unpack_checked(ser, src.mtime);
+    unpack_checked(ser, src.hash);
+  }
+}
+
+static bool
+source_unchanged(const image_source& src)
+{
+  uint64_t size;
+  int64_t mtime;
+  if (!stat_source(src.path, size, mtime)){
+    return false;
+  }
+  //a matching mtime is not proof enough, e.g. after a copy that preserves it
+  return size == src.size && mtime == src.mtime && hash_source(src.path) == src.hash;
+}
 
 double
 get_freq_from_str(const char* val, const char* key)
@@ -109,6 +236,43 @@ get_bandwidth_from_str(const char* val, const char* key)
   return ret;
 }
 
+long
+get_long_from_str(const char* val, const char* key)
+{
+  char* end = const_cast<char*>(val);
+  long ret = ::strtol(val, &end, 0);
+  if (val == end) {
+    spkt_abort_printf("sim_parameters: param %s with value %s is not formatted as an integer",
+                     key, val);
+  }
+  return ret;
+}
+
+double
+get_double_from_str(const char* val, const char* key)
+{
+  char* end = const_cast<char*>(val);
+  double ret = ::strtod(val, &end);
+  if (val == end) {
+    spkt_abort_printf("sim_parameters: param %s with value %s is not formatted as a double",
+                     key, val);
+  }
+  return ret;
+}
+
+bool
+get_bool_from_str(const std::string& val, const char* key)
+{
+  if (val == "true" || val == "1") {
+    return true;
+  }
+  else if (val != "false" && val != "0") {
+    spkt_abort_printf("sim_parameters: param %s with value %s is not formatted as a proper boolean",
+                     key, val.c_str());
+  }
+  return false;
+}
+
 param_assign::operator int() const
 {
   return get_quantity_with_units(param_.c_str(), key_.c_str());
@@ -123,12 +287,21 @@ void
 param_assign::operator=(int x)
 {
   param_ = sprockit::printf("%d", x); 
+  sim_parameters::invalidate_caches();
 }
 
 void
 param_assign::operator=(double x)
 {
   param_ = sprockit::printf("%f", x); 
+  sim_parameters::invalidate_caches();
+}
+
+void
+param_assign::operator=(const std::string& str)
+{
+  param_ = str;
+  sim_parameters::invalidate_caches();
 }
 
 double
@@ -159,18 +332,21 @@ void
 param_assign::set(const char* str)
 {
   param_ = str;
+  sim_parameters::invalidate_caches();
 }
 
 void
 param_assign::set(const std::string& str)
 {
   param_ = str;
+  sim_parameters::invalidate_caches();
 }
 
 void
 param_assign::setValue(double x, const char* units)
 {
   param_ = sprockit::printf("%f%s", x, units);
+  sim_parameters::invalidate_caches();
 }
 
 void
@@ -198,26 +374,41 @@ param_assign::setByteLength(long x, const char* units)
 }
 
 sim_parameters::sim_parameters() :
-  parent_(0)
+  cache_lock_(0),
+  parent_(0),
+  frozen_(0),
+  frozen_scope_(0)
 {
 }
 
 sim_parameters::sim_parameters(const key_value_map& p) :
-  params_(p),
-  parent_(0)
-{
+  cache_lock_(0),
+  parent_(0),
+  frozen_(0),
+  frozen_scope_(0)
+{
+  key_value_map::const_iterator it, end = p.end();
+  for (it=p.begin(); it != end; ++it){
+    params_[param_key::intern(it->first)] = it->second;
+  }
 }
 
 sim_parameters::sim_parameters(const std::string& filename) :
-  parent_(0)
+  cache_lock_(0),
+  parent_(0),
+  frozen_(0),
+  frozen_scope_(0)
 {
   parse_file(filename);
 }
 
 sim_parameters::~sim_parameters()
 {
+  if (frozen_ && !parent_){
+    delete frozen_;
+  }
   params_.clear();
-  std::map<std::string, sim_parameters*>::const_iterator it, end = subspaces_.end();
+  namespace_table::const_iterator it, end = subspaces_.end();
   for (it=subspaces_.begin(); it != end; ++it){
     sim_parameters* subspace = it->second;
     delete subspace;
@@ -225,9 +416,42 @@ sim_parameters::~sim_parameters()
 }
 
 std::string
-sim_parameters::get_param(const std::string &key)
+sim_parameters::get_param(const param_key& key)
+{
+  return require_param(key);
+}
+
+bool
+sim_parameters::get_cached(const param_key& key, units_type units, double& val) const
+{
+  //a frozen tree is shared between threads and never written
+  if (frozen_) return false;
+  unsigned long generation = write_generation();
+  bool found = false;
+  lock_cache();
+  value_cache::const_iterator it = cache_.find(key.id());
+  if (it != cache_.end()){
+    const cached_value& cached = it->second;
+    if (cached.generation == generation && cached.units == units){
+      val = cached.value;
+      found = true;
+    }
+  }
+  unlock_cache();
+  return found;
+}
+
+void
+sim_parameters::set_cached(const param_key& key, units_type units, double val) const
 {
-  return go_get_param(key);
+  if (frozen_) return;
+  unsigned long generation = write_generation();
+  lock_cache();
+  cached_value& cached = cache_[key.id()];
+  cached.generation = generation;
+  cached.units = units;
+  cached.value = val;
+  unlock_cache();
 }
 
 bool
@@ -240,7 +464,7 @@ sim_parameters*
 sim_parameters::get_optional_namespace(const std::string &ns) const
 {
   KeywordRegistration::validate_namespace(ns);
-  std::map<std::string, sim_parameters*>::const_iterator it = subspaces_.find(ns);
+  namespace_table::const_iterator it = subspaces_.find(ns);
   if (it == subspaces_.end()){
     return empty_ns_params_;
   } else {
@@ -252,7 +476,7 @@ sim_parameters*
 sim_parameters::get_namespace(const std::string &ns) const
 {
   KeywordRegistration::validate_namespace(ns);
-  std::map<std::string, sim_parameters*>::const_iterator it = subspaces_.find(ns);
+  namespace_table::const_iterator it = subspaces_.find(ns);
   if (it == subspaces_.end()){
     spkt_throw_printf(input_error,
         "cannot enter namespace %s, does not exist",
@@ -270,8 +494,12 @@ sim_parameters::copy_param(const std::string &oldname, const std::string &newnam
 void
 sim_parameters::copy_optional_param(const std::string &oldname, const std::string &newname)
 {
-  if (has_param(oldname))
-    add_param_override(newname, get_param(oldname));
+  const std::string* val = find_local_param(oldname);
+  if (val){
+    //copy first - the override may rehash the map val points into
+    std::string copy(*val);
+    add_param_override(newname, copy);
+  }
 }
 
 void
@@ -294,12 +522,12 @@ sim_parameters::add_param_override(const std::string &key, int val)
 }
 
 void
-sim_parameters::get_vector_param(const std::string& key,
+sim_parameters::get_vector_param(const param_key& key,
                                  std::vector<std::string>& vals)
 {
   std::deque<std::string> tok;
   std::string space = " ";
-  std::string param_value_str = get_param(key);
+  const std::string& param_value_str = require_param(key);
   pst::BasicStringTokenizer::tokenize(param_value_str, tok, space);
   std::deque<std::string>::const_iterator it, end = tok.end();
   for (it = tok.begin(); it != end; ++it) {
@@ -311,114 +539,109 @@ sim_parameters::get_vector_param(const std::string& key,
 }
 
 std::string
-sim_parameters::deprecated_param(const std::string &key)
+sim_parameters::deprecated_param(const param_key& key)
 {
   return get_param(key);
 }
 
 std::string
-sim_parameters::deprecated_optional_param(const std::string &key, const std::string &def)
+sim_parameters::deprecated_optional_param(const param_key& key, const std::string &def)
 {
   return get_optional_param(key, def);
 }
 
 std::string
-sim_parameters::get_optional_param(const std::string &key, const std::string &def)
+sim_parameters::get_optional_param(const param_key& key, const std::string &def)
 {
-  if (has_param(key)) {
-    return get_param(key);
-  } else if (parent_){
-    return parent_->get_optional_param(key,def);
-  } else {
-   return def;
-  }
+  const std::string* val = find_param(key);
+  return val ? *val : def;
 }
 
 sim_parameters*
-sim_parameters::get_param_scope(const std::string& ns)
+sim_parameters::get_param_scope(string_ref ns)
 {
-  sim_parameters*& params = subspaces_[ns];
-  if (params == 0){
-   params = subspace_clone();
-   params->set_parent(this);
+  namespace_table::iterator it = subspaces_.find(ns);
+  if (it != subspaces_.end()){
+    return it->second;
   }
+  //refuse before inserting anything, so a frozen tree is left as it was
+  check_not_frozen(ns.str());
+  sim_parameters* params = subspace_clone();
+  params->set_parent(this);
+  subspaces_[ns] = params;
   return params;
 }
 
 long
-sim_parameters::get_long_param(const std::string &key)
+sim_parameters::get_long_param(const param_key& key)
 {
-  std::string v = get_param(key);
-  const char* begin = v.c_str();
-  char* end = const_cast<char*>(begin);
-  long ret = ::strtol(begin, &end, 0);
-  if (begin == end) {
-    spkt_abort_printf("sim_parameters::get_long_param: param %s with value %s is not formatted as an integer",
-                     key.c_str(), v.c_str());
-  }
-  return ret;
+  return get_long_from_str(require_param(key).c_str(), key.name().c_str());
 }
 
 long
-sim_parameters::deprecated_long_param(const std::string &key)
+sim_parameters::deprecated_long_param(const param_key& key)
 {
   return get_long_param(key);
 }
 
 long
-sim_parameters::deprecated_optional_long_param(const std::string &key, long def)
+sim_parameters::deprecated_optional_long_param(const param_key& key, long def)
 {
   return get_optional_long_param(key, def);
 }
 
 long
-sim_parameters::get_optional_long_param(const std::string &key, long def)
+sim_parameters::get_optional_long_param(const param_key& key, long def)
 {
-  if (has_param(key)) {
-    return get_long_param(key);
-  }
-  return def;
+  const std::string* val = find_param(key);
+  return val ? get_long_from_str(val->c_str(), key.name().c_str()) : def;
 }
 
 
 double
-sim_parameters::get_time_param(const std::string& key)
+sim_parameters::get_time_param(const param_key& key)
 {
-  return get_time_from_str(get_param(key).c_str(), key.c_str());
-
+  double val;
+  if (!get_cached(key, time_units, val)){
+    val = get_time_from_str(require_param(key).c_str(), key.name().c_str());
+    set_cached(key, time_units, val);
+  }
+  return val;
 }
 
 double
-sim_parameters::deprecated_time_param(const std::string &key)
+sim_parameters::deprecated_time_param(const param_key& key)
 {
   return get_time_param(key);
 }
 
 double
-sim_parameters::get_optional_time_param(const std::string &key,
-                                        double def)
-{
-  if (has_param(key)) {
-    return get_time_param(key);
-  }
-  return def;
+sim_parameters::get_optional_time_param(const param_key& key, double def)
+{
+  double val;
+  if (get_cached(key, time_units, val)) return val;
+  const std::string* str = find_param(key);
+  if (!str) return def;
+  val = get_time_from_str(str->c_str(), key.name().c_str());
+  set_cached(key, time_units, val);
+  return val;
 }
 
 double
-sim_parameters::deprecated_optional_time_param(const std::string &key,
+sim_parameters::deprecated_optional_time_param(const param_key& key,
     double def)
 {
   return get_optional_time_param(key, def);
 }
 
 double
-sim_parameters::reread_double_param(const std::string &key)
+sim_parameters::reread_double_param(const param_key& key)
 {
   return get_double_param(key);
 }
 
 double
-sim_parameters::reread_optional_double_param(const std::string &key,
+sim_parameters::reread_optional_double_param(const param_key& key,
     double def)
 {
   return get_optional_double_param(key, def);
@@ -426,160 +649,132 @@ sim_parameters::reread_optional_double_param(const std::string &key,
 
 
 double
-sim_parameters::get_quantity(const std::string& key)
+sim_parameters::get_quantity(const param_key& key)
 {
-  bool error = false;
-  std::string value = get_param(key);
-  return get_quantity_with_units(value.c_str(), key.c_str());
+  double val;
+  if (!get_cached(key, quantity_units, val)){
+    val = get_quantity_with_units(require_param(key).c_str(), key.name().c_str());
+    set_cached(key, quantity_units, val);
+  }
+  return val;
 }
 
 double
-sim_parameters::get_optional_quantity(const std::string &key, double def)
-{
-  if (has_param(key)){
-    return get_quantity(key);
-  } else {
-    return def;
-  }
+sim_parameters::get_optional_quantity(const param_key& key, double def)
+{
+  double val;
+  if (get_cached(key, quantity_units, val)) return val;
+  const std::string* str = find_param(key);
+  if (!str) return def;
+  val = get_quantity_with_units(str->c_str(), key.name().c_str());
+  set_cached(key, quantity_units, val);
+  return val;
 }
 
 double
-sim_parameters::get_double_param(const std::string& key)
+sim_parameters::get_double_param(const param_key& key)
 {
-  std::string v = get_param(key);
-  const char* begin = v.c_str();
-  char* end = const_cast<char*>(begin);
-  double ret = ::strtod(begin, &end);
-  if (begin == end) {
-    spkt_abort_printf("sim_parameters::get_double_param: param %s with value %s is not formatted as a double",
-                     key.c_str(), v.c_str());
-  }
-  return ret;
+  return get_double_from_str(require_param(key).c_str(), key.name().c_str());
 }
 
 double
-sim_parameters::get_optional_double_param(const std::string &key, double def)
+sim_parameters::get_optional_double_param(const param_key& key, double def)
 {
-  if (has_param(key)) {
-    return get_double_param(key);
-  }
-
-  return def;
+  const std::string* val = find_param(key);
+  return val ? get_double_from_str(val->c_str(), key.name().c_str()) : def;
 }
 
 double
-sim_parameters::deprecated_double_param(const std::string &key)
+sim_parameters::deprecated_double_param(const param_key& key)
 {
   return get_double_param(key);
 }
 
 double
-sim_parameters::deprecated_optional_double_param(const std::string &key, double def)
+sim_parameters::deprecated_optional_double_param(const param_key& key, double def)
 {
   return get_optional_double_param(key, def);
 }
 
 
 int
-sim_parameters::deprecated_optional_int_param(const std::string &key, int def)
+sim_parameters::deprecated_optional_int_param(const param_key& key, int def)
 {
   return get_optional_int_param(key, def);
 }
 
 int
-sim_parameters::get_optional_int_param(const std::string &key, int def)
+sim_parameters::get_optional_int_param(const param_key& key, int def)
 {
-  if (has_param(key)) {
-    return get_int_param(key);
-  }
-  return def;
+  const std::string* val = find_param(key);
+  return val ? get_long_from_str(val->c_str(), key.name().c_str()) : def;
 }
 
 int
-sim_parameters::get_int_param(const std::string& key)
+sim_parameters::get_int_param(const param_key& key)
 {
-  std::string v = get_param(key);
-  const char* begin = v.c_str();
-  char* end = const_cast<char*>(begin);
-  long ret = ::strtol(begin, &end, 0);
-  if (begin == end) {
-    spkt_abort_printf("sim_parameters::get_int_param: param %s with value %s is not formatted as an integer",
-                     key.c_str(), v.c_str());
-  }
-  return ret;
+  return get_long_from_str(require_param(key).c_str(), key.name().c_str());
 }
 
 int
-sim_parameters::reread_optional_int_param(const std::string &key, int def)
+sim_parameters::reread_optional_int_param(const param_key& key, int def)
 {
   return get_optional_int_param(key,def);
 }
 
 int
-sim_parameters::reread_int_param(const std::string &key)
+sim_parameters::reread_int_param(const param_key& key)
 {
   return get_int_param(key);
 }
 
 int
-sim_parameters::deprecated_int_param(const std::string &key)
+sim_parameters::deprecated_int_param(const param_key& key)
 {
   return get_int_param(key);
 }
 
 bool
-sim_parameters::deprecated_optional_bool_param(const std::string &key, bool def)
+sim_parameters::deprecated_optional_bool_param(const param_key& key, bool def)
 {
   return get_optional_bool_param(key, def);
 }
 
 bool
-sim_parameters::get_optional_bool_param(const std::string &key, int def)
+sim_parameters::get_optional_bool_param(const param_key& key, int def)
 {
-  if (has_param(key)) {
-    return get_bool_param(key);
-  }
-  return def;
+  const std::string* val = find_param(key);
+  return val ? get_bool_from_str(*val, key.name().c_str()) : def;
 }
 
 bool
-sim_parameters::reread_optional_bool_param(const std::string &key, bool def)
+sim_parameters::reread_optional_bool_param(const param_key& key, bool def)
 {
   return get_optional_bool_param(key,def);
 }
 
 bool
-sim_parameters::reread_bool_param(const std::string &key)
+sim_parameters::reread_bool_param(const param_key& key)
 {
   return get_bool_param(key);
 }
 
 bool
-sim_parameters::deprecated_bool_param(const std::string &key)
+sim_parameters::deprecated_bool_param(const param_key& key)
 {
   return get_bool_param(key);
 }
 
 bool
-sim_parameters::get_bool_param(const std::string &key)
+sim_parameters::get_bool_param(const param_key& key)
 {
-  std::string v = get_param(key);
-  if (v == "true" || v == "1") {
-    return true;
-  }
-  else if (v != "false" && v != "0") {
-    spkt_abort_printf("sim_parameters::get_bool_param: param %s with value %s is not formatted as a proper boolean",
-                     key.c_str(), v.c_str());
-  }
-  return false;
+  return get_bool_from_str(require_param(key), key.name().c_str());
 }
 
 void
-sim_parameters::get_vector_param(const std::string& key, std::vector<double>& vals)
+sim_parameters::get_vector_param(const param_key& key, std::vector<double>& vals)
 {
-  bool errorflag = false;
-  std::string param_value_str = get_param(key);
-  std::stringstream sstr(param_value_str);
+  std::stringstream sstr(require_param(key));
   vals.reserve(10); //optimistically assume not that big
   while (sstr && sstr.tellg() != -1){
     double val;
@@ -589,128 +784,144 @@ sim_parameters::get_vector_param(const std::string& key, std::vector<double>& va
 }
 
 void
-sim_parameters::get_vector_param(const std::string& key, std::vector<int>& vals)
+sim_parameters::get_vector_param(const param_key& key, std::vector<int>& vals)
 {
   bool errorflag = false;
-  std::string param_value_str = get_param(key);
+  const std::string& param_value_str = require_param(key);
   get_intvec(param_value_str.c_str(), errorflag, vals);
   if (errorflag) {
     spkt_abort_printf("improperly formatted integer vector (%s) for parameter %s",
-                     param_value_str.c_str(), key.c_str());
+                     param_value_str.c_str(), key.name().c_str());
   }
 }
 
 double
-sim_parameters::get_freq_param(const std::string &key)
+sim_parameters::get_freq_param(const param_key& key)
 {
-  bool errorflag = false;
-  std::string param_value_str = get_param(key);
-  return get_freq_from_str(param_value_str.c_str(), key.c_str());
+  double val;
+  if (!get_cached(key, freq_units, val)){
+    val = get_freq_from_str(require_param(key).c_str(), key.name().c_str());
+    set_cached(key, freq_units, val);
+  }
+  return val;
 }
 
 double
-sim_parameters::deprecated_freq_param(const std::string &key)
+sim_parameters::deprecated_freq_param(const param_key& key)
 {
   return get_freq_param(key);
 }
 
 double
-sim_parameters::deprecated_optional_freq_param(const std::string &key, double def)
+sim_parameters::deprecated_optional_freq_param(const param_key& key, double def)
 {
   return get_optional_freq_param(key, def);
 }
 
 double
-sim_parameters::get_optional_freq_param(const std::string &key, double def)
-{
-  bool errorflag = false;
-  std::string freq_str = printf("%eHz", def);
-  std::string param_value_str = get_optional_param(key, freq_str);
-  return get_freq_from_str(param_value_str.c_str(), key.c_str());
+sim_parameters::get_optional_freq_param(const param_key& key, double def)
+{
+  double val;
+  if (get_cached(key, freq_units, val)) return val;
+  const std::string* str = find_param(key);
+  if (!str) return def;
+  val = get_freq_from_str(str->c_str(), key.name().c_str());
+  set_cached(key, freq_units, val);
+  return val;
 }
 
 long
-sim_parameters::get_byte_length_param(const std::string &key)
+sim_parameters::get_byte_length_param(const param_key& key)
 {
-  bool errorflag = false;
-  std::string param_value_str = get_param(key);
-  return get_byte_length_from_str(param_value_str.c_str(), key.c_str());
+  double val;
+  if (!get_cached(key, byte_length_units, val)){
+    val = get_byte_length_from_str(require_param(key).c_str(), key.name().c_str());
+    set_cached(key, byte_length_units, val);
+  }
+  return long(val);
 }
 
 long
-sim_parameters::deprecated_byte_length_param(const std::string &key)
+sim_parameters::deprecated_byte_length_param(const param_key& key)
 {
   return get_byte_length_param(key);
 }
 
 long
-sim_parameters::deprecated_optional_byte_length_param(const std::string &key, long def)
+sim_parameters::deprecated_optional_byte_length_param(const param_key& key, long def)
 {
   return get_optional_byte_length_param(key, def);
 }
 
 long
-sim_parameters::get_optional_byte_length_param(const std::string& key, long length)
+sim_parameters::get_optional_byte_length_param(const param_key& key, long length)
 {
-  std::string length_str = printf("%ldB", length);
-  std::string param_value_str = get_optional_param(key, length_str);
-  return get_byte_length_from_str(param_value_str.c_str(), key.c_str());
+  double val;
+  if (get_cached(key, byte_length_units, val)) return long(val);
+  const std::string* str = find_param(key);
+  if (!str) return length;
+  val = get_byte_length_from_str(str->c_str(), key.name().c_str());
+  set_cached(key, byte_length_units, val);
+  return long(val);
 }
 
 double
-sim_parameters::get_bandwidth_param(const std::string &key)
+sim_parameters::get_bandwidth_param(const param_key& key)
 {
-  std::string param_value_str = get_param(key);
-  return get_bandwidth_from_str(param_value_str.c_str(), key.c_str());
+  double val;
+  if (!get_cached(key, bandwidth_units, val)){
+    val = get_bandwidth_from_str(require_param(key).c_str(), key.name().c_str());
+    set_cached(key, bandwidth_units, val);
+  }
+  return val;
 }
 
 double
-sim_parameters::reread_bandwidth_param(const std::string &key)
+sim_parameters::reread_bandwidth_param(const param_key& key)
 {
   return get_bandwidth_param(key);
 }
 
 double
-sim_parameters::reread_optional_bandwidth_param(const std::string &key, double def)
+sim_parameters::reread_optional_bandwidth_param(const param_key& key, double def)
 {
   return get_optional_bandwidth_param(key, def);
 }
 
 double
-sim_parameters::deprecated_bandwidth_param(const std::string &key)
+sim_parameters::deprecated_bandwidth_param(const param_key& key)
 {
   return get_bandwidth_param(key);
 }
 
 double
-sim_parameters::deprecated_optional_bandwidth_param(const std::string &key, double def)
+sim_parameters::deprecated_optional_bandwidth_param(const param_key& key, double def)
 {
   return get_optional_bandwidth_param(key, def);
 }
 
 double
-sim_parameters::get_optional_bandwidth_param(const std::string &key, const std::string& def)
+sim_parameters::get_optional_bandwidth_param(const param_key& key, const std::string& def)
 {
-  bool errorflag = false;
-  std::string param_value_str = get_optional_param(key, def);
-  double val = get_bandwidth(param_value_str.c_str(), errorflag);
-  if (errorflag) {
-    spkt_abort_printf("improperly formatted bandwidth (%s) for parameter %s",
-                     param_value_str.c_str(), key.c_str());
-  }
-  return val;
+  const std::string* val = find_param(key);
+  return get_bandwidth_from_str(val ? val->c_str() : def.c_str(), key.name().c_str());
 }
 
 double
-sim_parameters::get_optional_bandwidth_param(const std::string &key, double def)
-{
-  std::string bwstr = printf("%ebytes/sec", def);
-  return get_optional_bandwidth_param(key, bwstr);
+sim_parameters::get_optional_bandwidth_param(const param_key& key, double def)
+{
+  double val;
+  if (get_cached(key, bandwidth_units, val)) return val;
+  const std::string* str = find_param(key);
+  if (!str) return def;
+  val = get_bandwidth_from_str(str->c_str(), key.name().c_str());
+  set_cached(key, bandwidth_units, val);
+  return val;
 }
 
 void
 sim_parameters::print_params(
-    const key_value_map &pmap,
+    const id_value_map &pmap,
     std::ostream &os,
     bool pretty_print,
     std::list<std::string>& namespaces) const
@@ -730,9 +941,9 @@ sim_parameters::print_params(
   }
   std::string prefix = sstr.str();
 
-  key_value_map::const_iterator it, end = pmap.end();
+  id_value_map::const_iterator it, end = pmap.end();
   for (it = pmap.begin() ; it != end; ++it) {
-    std::string key = it->first;
+    const std::string& key = param_key::key_name(it->first);
     std::string value = it->second;
     os << prefix << key;
     if (pretty_print){
@@ -743,7 +954,7 @@ sim_parameters::print_params(
     os << " = " << value << "\n";
   }
 
-  std::map<std::string, sim_parameters*>::const_iterator nsit, nsend = subspaces_.end();
+  namespace_table::const_iterator nsit, nsend = subspaces_.end();
   for (nsit=subspaces_.begin(); nsit != nsend; ++nsit){
     std::string ns = nsit->first;
     sim_parameters* subspace = nsit->second;
@@ -781,46 +992,50 @@ sim_parameters::try_to_parse(const std::string& fname, bool fail_on_existing)
 }
 
 sim_parameters*
-sim_parameters::get_scope_and_key(const std::string& key, std::string& final_key)
+sim_parameters::get_scope_and_key(string_ref key, string_ref& final_key)
 {
+  //segments are views into key - a string is only built for a new namespace
   sim_parameters* scope = this;
   final_key = key;
-  size_t ns_pos = final_key.find(".");
-  while (ns_pos != std::string::npos) {
-    std::string ns = final_key.substr(0, ns_pos);
-    final_key  = final_key.substr(ns_pos+1);
-    scope = scope->get_param_scope(ns);
-    ns_pos = final_key.find(".");
+  size_t ns_pos = final_key.find('.');
+  while (ns_pos != string_ref::npos) {
+    scope = scope->get_param_scope(final_key.substr(0, ns_pos));
+    final_key = final_key.substr(ns_pos+1);
+    ns_pos = final_key.find('.');
   }
   return scope;
 }
 
 void
 sim_parameters::parse_keyval(
-    const std::string& key,
+    string_ref key,
     const std::string& value,
     bool fail_on_existing)
 {
-  std::string final_key;
+  string_ref final_key;
   sim_parameters* scope = get_scope_and_key(key, final_key);
   scope->do_add_param(final_key, value, fail_on_existing);
 }
 
 void
-sim_parameters::split_line(const std::string& line, std::pair<std::string, std::string>& p)
+sim_parameters::split_line(string_ref line, string_ref& key, string_ref& value)
 {
-  std::string lhs = line.substr(0, line.find("="));
-  std::string rhs = line.substr(line.find("=") + 1);
-  p.first = sprockit::trim_str(lhs);
-  p.second = sprockit::trim_str(rhs);
+  size_t eq = line.find('=');
+  if (eq == string_ref::npos){
+    key = line.trim();
+    value = string_ref();
+  } else {
+    key = line.substr(0, eq).trim();
+    value = line.substr(eq + 1).trim();
+  }
 }
 
 void
 sim_parameters::parse_line(const std::string& line, bool fail_on_existing)
 {
-  std::pair<std::string, std::string> keyval;
-  sim_parameters::split_line(line, keyval);
-  parse_keyval(keyval.first, keyval.second, fail_on_existing);
+  string_ref key, value;
+  split_line(line, key, value);
+  parse_keyval(key, value.str(), fail_on_existing);
 }
 
 void
@@ -877,43 +1092,102 @@ sim_parameters::parallel_build_params(sprockit::sim_parameters* params, int me,
 void
 sim_parameters::parse_stream(std::istream& in, bool fail_on_existing)
 {
-  std::string line;
-  while (in.good()) {
-    std::getline(in, line);
-    line = trim_str(line);
+  std::string text((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  parse_text(text, fail_on_existing);
+}
 
-    if (line[0] == '#') {
-      //a comment
-      continue;
-    }
-    else if (line.find("set var ") != std::string::npos) {
-      line = line.substr(8);
-      std::pair<std::string, std::string> keyval;
-      sim_parameters::split_line(line, keyval);
-      variables_[keyval.first] = keyval.second;
-    }
-    else if (line.find("=") != std::string::npos) {
-      //an assignment
-      parse_line(line);
-    }
-    else if (line.find("include") != std::string::npos) {
-      //an include line
-      std::string included_file = trim_str(line.substr(7));
-      try_to_parse(included_file, fail_on_existing);
+void
+sim_parameters::parse_text(string_ref text, bool fail_on_existing)
+{
+  size_t pos = 0;
+  while (pos < text.size()){
+    //memchr does the newline search a vector at a time
+    size_t eol = text.find('\n', pos);
+    if (eol == string_ref::npos) eol = text.size();
+    parse_directive(text.substr(pos, eol - pos).trim(), fail_on_existing);
+    pos = eol + 1;
+  }
+}
+
+void
+sim_parameters::parse_directive(string_ref line, bool fail_on_existing)
+{
+  pvt::param_directive d;
+  if (pvt::classify_param_line(line, d)){
+    apply_directive(d, fail_on_existing, true);
+  }
+}
+
+void
+sim_parameters::apply_directive(const pvt::param_directive& d,
+  bool fail_on_existing, bool validate)
+{
+  switch (d.kind){
+    case pvt::param_directive::set_var:
+      variables_[d.key.str()] = d.value.str();
+      break;
+    case pvt::param_directive::assign: {
+      string_ref final_key;
+      sim_parameters* scope = get_scope_and_key(d.key, final_key);
+      scope->do_add_param(final_key, d.value.str(), false, validate);
+      break;
     }
-    else if (line.find("unset") != std::string::npos) {
-      std::string key;
-      sim_parameters* scope = get_scope_and_key(trim_str(line.substr(5)), key);
+    case pvt::param_directive::include:
+      try_to_parse(d.key.str(), fail_on_existing);
+      break;
+    case pvt::param_directive::unset: {
+      string_ref key;
+      sim_parameters* scope = get_scope_and_key(d.key, key);
       scope->remove_param(key);
+      break;
     }
-    else if (line.size() == 0) {
-      //empty
-    }
-    else {
-      spkt_throw_printf(input_error, "invalid input file line of size %d:\n%s---", line.size(), line.c_str());
+  }
+}
+
+void
+sim_parameters::parse_file_parallel(const std::string& fname, int nthreads,
+  bool fail_on_existing)
+{
+#if SPKT_HAVE_CPP11
+  pvt::param_include_graph graph(nthreads);
+  graph.build(fname);
+  replay(graph, graph.root(), fail_on_existing);
+#else
+  parse_file(fname, fail_on_existing);
+#endif
+}
+
+#if SPKT_HAVE_CPP11
+void
+sim_parameters::replay(const pvt::param_include_graph& graph, pvt::param_file* f,
+  bool fail_on_existing)
+{
+  if (f->applying){
+    spkt_throw_printf(input_error,
+      "parameter file %s includes itself", f->path.c_str());
+  }
+  if (!f->path.empty()){
+    add_source_file(f->path);
+  }
+
+  f->applying = true;
+  std::vector<pvt::param_directive>::const_iterator it, end = f->directives.end();
+  for (it=f->directives.begin(); it != end; ++it){
+    if (it->kind == pvt::param_directive::include){
+      replay(graph, graph.included(it->key), fail_on_existing);
+    } else {
+      //keywords were validated while the file was read
+      apply_directive(*it, fail_on_existing, false);
     }
   }
+  f->applying = false;
+
+  if (f->error){
+    std::rethrow_exception(f->error);
+  }
 }
+#endif
 
 void
 sim_parameters::parse_file(const std::string& input_fname,
@@ -921,47 +1195,288 @@ sim_parameters::parse_file(const std::string& input_fname,
 {
   std::string fname = trim_str(input_fname);
 
-  std::ifstream in;
+  mapped_file in;
   SpktFileIO::open_file(in, fname);
 
   if (in.is_open()) {
-    parse_stream(in, fail_on_existing);
+    add_source_file(in.path());
+    parse_text(in.contents(), fail_on_existing);
   } else {
     SpktFileIO::not_found(fname);
   }
 }
 
 void
-sim_parameters::remove_param(const std::string & key)
+sim_parameters::remove_param(const param_key& key)
 {
-  params_.erase(key);
+  check_not_frozen(key.name());
+  params_.erase(key.id());
+  invalidate_caches();
 }
 
-std::string
-sim_parameters::go_get_param(const std::string& key, bool throw_on_error) const
+const std::string*
+sim_parameters::find_param(const param_key& key) const
 {
   debug_printf(dbg::params | dbg::read_params,
     "sim_parameters: getting key %s\n",
-    key.c_str());
+    key.name().c_str());
 
-  key_value_map::const_iterator it = params_.find(key);
-  if (it == params_.end()) {
-    if (parent_){
-      std::string val = parent_->go_get_param(key, false);
-      if (val.size()) return val;
+  if (frozen_){
+    return frozen_->find(frozen_scope_, key.id());
+  }
+
+  uint32_t id = key.id();
+  const sim_parameters* scope = this;
+  while (scope){
+    id_value_map::const_iterator it = scope->params_.find(id);
+    if (it != scope->params_.end()){
+      return &it->second;
     }
+    scope = scope->parent_;
+  }
+  return 0;
+}
 
-    if (throw_on_error){
-      const sim_parameters* top = top_parent();
-      std::cerr << "Parameters given in namespace: " << std::endl;
-      print_params(std::cerr);
-      spkt_throw_printf(sprockit::value_error,
-               "sim_parameters: could not find parameter %s", key.c_str());
-    } else {
-      return "";
+const std::string&
+sim_parameters::require_param(const param_key& key) const
+{
+  const std::string* val = find_param(key);
+  if (!val){
+    std::cerr << "Parameters given in namespace: " << std::endl;
+    print_params(std::cerr);
+    spkt_throw_printf(sprockit::value_error,
+             "sim_parameters: could not find parameter %s", key.name().c_str());
+  }
+  return *val;
+}
+
+void
+sim_parameters::freeze()
+{
+  sim_parameters* top = this;
+  while (top->parent_){
+    top = top->parent_;
+  }
+  if (top->frozen_) return;
+
+  param_image* image = new param_image;
+  top->compile_into(image, param_image::no_scope);
+  image->finish();
+}
+
+void
+sim_parameters::compile_into(param_image* image, uint32_t parent_scope)
+{
+  frozen_scope_ = image->begin_scope(parent_scope);
+  id_value_map::const_iterator it, end = params_.end();
+  for (it=params_.begin(); it != end; ++it){
+    image->add_value(it->first, it->second);
+  }
+  frozen_ = image;
+  cache_.clear();
+
+  namespace_table::const_iterator nit, nend = subspaces_.end();
+  for (nit=subspaces_.begin(); nit != nend; ++nit){
+    nit->second->compile_into(image, frozen_scope_);
+  }
+}
+
+void
+sim_parameters::add_source_file(const std::string& path)
+{
+  sim_parameters* top = this;
+  while (top->parent_){
+    top = top->parent_;
+  }
+  std::vector<std::string>& files = top->source_files_;
+  if (std::find(files.begin(), files.end(), path) == files.end()){
+    files.push_back(path);
+  }
+}
+
+void
+sim_parameters::pack_image(serializer& ser) const
+{
+  uint32_t nparams = params_.size();
+  ser & nparams;
+  id_value_map::const_iterator it, end = params_.end();
+  for (it=params_.begin(); it != end; ++it){
+    //packing only reads
+    ser & const_cast<std::string&>(param_key::key_name(it->first));
+    ser & const_cast<std::string&>(it->second);
+  }
+
+  uint32_t nspaces = subspaces_.size();
+  ser & nspaces;
+  namespace_table::const_iterator nit, nend = subspaces_.end();
+  for (nit=subspaces_.begin(); nit != nend; ++nit){
+    ser & const_cast<std::string&>(nit->first);
+    nit->second->pack_image(ser);
+  }
+}
+
+void
+sim_parameters::unpack_image(serializer& ser, bool validate, bool apply)
+{
+  std::string name, value;
+  uint32_t nparams;
+  unpack_checked(ser, nparams);
+  check_image_count(ser, nparams, 2*sizeof(int));
+  for (uint32_t i=0; i < nparams; ++i){
+    unpack_checked(ser, name);
+    unpack_checked(ser, value);
+    if (validate){
+      KeywordRegistration::validate_keyword(name, value);
+    }
+    if (apply){
+      params_[param_key::intern(name)] = value;
     }
   }
-  return it->second;
+
+  uint32_t nspaces;
+  unpack_checked(ser, nspaces);
+  check_image_count(ser, nspaces, sizeof(int) + 2*sizeof(uint32_t));
+  for (uint32_t i=0; i < nspaces; ++i){
+    unpack_checked(ser, name);
+    sim_parameters* scope = apply ? get_param_scope(name) : this;
+    scope->unpack_image(ser, validate, apply);
+  }
+}
+
+void
+sim_parameters::save_image(const std::string& image_file) const
+{
+  const std::vector<std::string>& files = top_parent()->source_files_;
+  std::vector<image_source> sources(files.size());
+  for (size_t i=0; i < files.size(); ++i){
+    image_source& src = sources[i];
+    src.path = files[i];
+    if (!stat_source(src.path, src.size, src.mtime)){
+      spkt_throw_printf(io_error,
+        "sim_parameters: cannot stat source file %s", src.path.c_str());
+    }
+    src.hash = hash_source(src.path);
+  }
+
+  uint64_t magic = image_magic;
+  uint32_t version = image_version;
+  uint32_t validated = KeywordRegistration::do_validation_;
+  std::string root = files.empty() ? std::string() : files[0];
+  serializer ser;
+  std::vector<char> buffer;
+  for (int pass=0; pass < 2; ++pass){
+    ser & magic;
+    ser & version;
+    ser & validated;
+    ser & root;
+    serialize_sources(ser, sources);
+    pack_image(ser);
+    if (pass == 0){
+      buffer.resize(ser.size());
+      ser.start_packing(&buffer[0], buffer.size());
+    }
+  }
+
+  //other processes may be loading the image right now - never let them
+  //see a partly written one
+  std::stringstream tmp_sstr;
+  tmp_sstr << image_file << ".tmp." << ::getpid();
+  std::string tmp_file = tmp_sstr.str();
+  std::ofstream out(tmp_file.c_str(), std::ios::binary);
+  out.write(&buffer[0], buffer.size());
+  out.close();
+  if (!out || ::rename(tmp_file.c_str(), image_file.c_str()) != 0){
+    ::unlink(tmp_file.c_str());
+    spkt_throw_printf(io_error,
+      "sim_parameters: could not write parameter image %s", image_file.c_str());
+  }
+}
+
+bool
+sim_parameters::load_image(const std::string& image_file, bool check_sources,
+                           const std::string& root)
+{
+  check_not_frozen(image_file);
+  mapped_file in;
+  if (!in.open(image_file)){
+    return false;
+  }
+
+  //the unpacker only reads from the mapping
+  serializer ser;
+  ser.start_unpacking(const_cast<char*>(in.contents().data()), in.contents().size());
+  uint64_t magic;
+  uint32_t version;
+  uint32_t validated;
+  std::string image_root;
+  std::vector<image_source> sources;
+  try {
+    unpack_checked(ser, magic);
+    unpack_checked(ser, version);
+    if (magic != image_magic || version != image_version){
+      return false;
+    }
+    unpack_checked(ser, validated);
+    unpack_checked(ser, image_root);
+    unpack_sources(ser, sources);
+  } catch (const pvt::ser_buffer_overrun& e){
+    //truncated or not an image at all
+    return false;
+  }
+
+  if (!root.empty() && root != image_root){
+    return false;
+  }
+
+  if (check_sources){
+    for (size_t i=0; i < sources.size(); ++i){
+      if (!source_unchanged(sources[i])){
+        return false;
+      }
+    }
+  }
+
+  //decode the whole body before writing anything, so a corrupt image
+  //leaves the tree as it was. A keyword that fails validation still throws.
+  const char* data = in.contents().data();
+  size_t body = ser.size();
+  size_t body_size = in.contents().size() - body;
+  try {
+    unpack_image(ser, !validated && KeywordRegistration::do_validation_, false);
+  } catch (const pvt::ser_buffer_overrun& e){
+    return false;
+  }
+  ser.start_unpacking(const_cast<char*>(data) + body, body_size);
+  unpack_image(ser, false, true);
+  for (size_t i=0; i < sources.size(); ++i){
+    add_source_file(sources[i].path);
+  }
+  invalidate_caches();
+  return true;
+}
+
+void
+sim_parameters::parse_file_cached(const std::string& fname,
+  const std::string& image_file, bool fail_on_existing)
+{
+  //images record the root as found on the search path
+  mapped_file root;
+  SpktFileIO::open_file(root, trim_str(fname));
+  std::string root_path = root.is_open() ? root.path() : trim_str(fname);
+  root.close();
+  if (!load_image(image_file, true, root_path)){
+    parse_file(fname, fail_on_existing);
+    save_image(image_file);
+  }
+}
+
+void
+sim_parameters::check_not_frozen(const std::string& key) const
+{
+  if (frozen_){
+    spkt_throw_printf(sprockit::illformed_error,
+      "sim_parameters: cannot modify %s, parameters are frozen", key.c_str());
+  }
 }
 
 const sim_parameters*
@@ -973,49 +1488,82 @@ sim_parameters::top_parent() const
   return this;
 }
 
+const std::string*
+sim_parameters::find_local_param(const param_key& key) const
+{
+  if (frozen_){
+    return frozen_->find_local(frozen_scope_, key.id());
+  }
+  id_value_map::const_iterator it = params_.find(key.id());
+  return it == params_.end() ? 0 : &it->second;
+}
+
 bool
-sim_parameters::has_param(const std::string& key) const
+sim_parameters::has_param(const param_key& key) const
 {
-  return params_.find(key) != params_.end();
+  return find_local_param(key) != 0;
 }
 
 void
-sim_parameters::do_add_param(const std::string& key, const std::string& val,
-  bool fail_on_existing)
+sim_parameters::do_add_param(const param_key& key, const std::string& val,
+  bool fail_on_existing, bool validate)
 {
   if (val.c_str()[0] == '$'){
-    std::map<std::string, std::string>::const_iterator it = variables_.find(val.substr(1));
-    if (it == variables_.end()){
+    //variables are set on the scope being parsed, which encloses this one
+    std::string name = val.substr(1);
+    const sim_parameters* scope = this;
+    std::map<std::string, std::string>::const_iterator it;
+    while (scope && (it = scope->variables_.find(name)) == scope->variables_.end()){
+      scope = scope->parent_;
+    }
+    if (!scope){
       spkt_throw_printf(input_error,
         "unknown variable name %s", val.c_str());
     }
-    do_add_param(key, it->second, fail_on_existing);
+    do_add_param(key, it->second, fail_on_existing, validate);
     return;
   }
 
   debug_printf(dbg::params, //| dbg::write_params,
     "sim_parameters: setting key %s to value %s\n",
-    key.c_str(), val.c_str());
+    key.name().c_str(), val.c_str());
 
-  KeywordRegistration::validate_keyword(key,val);
+  if (validate){
+    KeywordRegistration::validate_keyword(key.name(),val);
+  }
 
-  key_value_map::iterator it = params_.find(key);
+  check_not_frozen(key.name());
+  invalidate_caches();
+  uint32_t id = key.interned_id();
+  id_value_map::iterator it = params_.find(id);
 
   if (it != params_.end()){
     if (fail_on_existing){
       spkt_throw_printf(sprockit::value_error,
-      "sim_parameters::add_param - key already in params: %s", key.c_str());
+      "sim_parameters::add_param - key already in params: %s", key.name().c_str());
     }
     it->second = val;
   } else {
-    params_.insert(it, std::make_pair(key, val));
+    params_.insert(it, std::make_pair(id, val));
   }
 }
 
+sim_parameters::iterator
+sim_parameters::begin()
+{
+  check_not_frozen("parameters through an iterator");
+  //the caller may write through it->second
+  invalidate_caches();
+  return params_.begin();
+}
+
 param_assign
 sim_parameters::operator[](const std::string& key)
 {
-  return param_assign(params_[key], key);
+  check_not_frozen(key);
+  //the caller may write through the returned reference
+  invalidate_caches();
+  return param_assign(params_[param_key::intern(key)], key);
 }
 
 void
@@ -1034,18 +1582,23 @@ sim_parameters::add_param_override(const std::string& key,
 void
 sim_parameters::combine_into(sim_parameters* sp)
 {
-  {key_value_map::iterator it, end = params_.end();
+  {id_value_map::iterator it, end = params_.end();
   for (it=params_.begin(); it != end; ++it){
-    sp->add_param_override(it->first, it->second);
+    sp->add_param_override(param_key::key_name(it->first), it->second);
   }}
 
-  {std::map<std::string, sim_parameters*>::iterator it, end = subspaces_.end();
+  {namespace_table::iterator it, end = subspaces_.end();
   for (it=subspaces_.begin(); it != end; ++it){
     std::string name = it->first;
     sim_parameters* my_subspace = it->second;
-    sim_parameters* &his_subspace = sp->subspaces_[name];
-    if (!his_subspace){
+    namespace_table::iterator his = sp->subspaces_.find(name);
+    sim_parameters* his_subspace;
+    if (his == sp->subspaces_.end()){
+      sp->check_not_frozen(name);
       his_subspace = new sim_parameters;
+      sp->subspaces_[name] = his_subspace;
+    } else {
+      his_subspace = his->second;
     }
     my_subspace->combine_into(his_subspace);
   }}
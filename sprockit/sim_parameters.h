@@ -14,9 +14,16 @@
 
 #include <sprockit/debug.h>
 #include <sprockit/unordered.h>
+#include <sprockit/param_key.h>
+#include <sprockit/string_ref.h>
+#include <sprockit/serializer_fwd.h>
 
 #include <iostream>
+#include <iterator>
+#include <cstddef>
+#include <algorithm>
 #include <list>
+#include <map>
 #include <vector>
 #include <set>
 
@@ -36,9 +43,7 @@ class param_assign {
 
   void operator=(int a);
   void operator=(double x);
-  void operator=(const std::string& str){
-    param_ = str;
-  }
+  void operator=(const std::string& str);
 
   void setByteLength(long x, const char* units);
   void setBandwidth(double x, const char* units);
@@ -76,10 +81,177 @@ class param_bcaster {
   bcast_string(std::string& str, int me, int root);
 };
 
+/**
+ * Iterates over the parameters of one scope as (name, value) pairs.
+ * Values are stored by key id, so each pair is built on dereference
+ * with the name taken from the param_key table. This replaces iterating
+ * a key_value_map: code that named key_value_map::iterator should use
+ * sim_parameters::iterator or const_iterator, and it->first and
+ * it->second read as before. It is a forward iterator whose reference
+ * is a proxy, as for std::vector<bool>.
+ */
+template <class Iterator, class Value>
+class param_iterator
+{
+ public:
+  struct value_type {
+    value_type(const std::string& k, Value& v) :
+      first(k), second(v)
+    {
+    }
+
+    const std::string& first;
+    Value& second;
+  };
+
+  class pointer {
+   public:
+    pointer(const value_type& v) : val_(v) {}
+
+    const value_type*
+    operator->() const {
+      return &val_;
+    }
+
+   private:
+    value_type val_;
+  };
+
+  typedef std::forward_iterator_tag iterator_category;
+  typedef std::ptrdiff_t difference_type;
+  typedef value_type reference;
+
+  param_iterator() {}
+
+  param_iterator(Iterator it) : it_(it) {}
+
+  template <class I, class V>
+  param_iterator(const param_iterator<I,V>& other) : it_(other.base()) {}
+
+  value_type
+  operator*() const {
+    return value_type(param_key::key_name(it_->first), it_->second);
+  }
+
+  pointer
+  operator->() const {
+    return pointer(**this);
+  }
+
+  param_iterator&
+  operator++() {
+    ++it_;
+    return *this;
+  }
+
+  param_iterator
+  operator++(int) {
+    param_iterator tmp(*this);
+    ++it_;
+    return tmp;
+  }
+
+  bool
+  operator==(const param_iterator& other) const {
+    return it_ == other.it_;
+  }
+
+  bool
+  operator!=(const param_iterator& other) const {
+    return it_ != other.it_;
+  }
+
+  const Iterator&
+  base() const {
+    return it_;
+  }
+
+ private:
+  Iterator it_;
+
+};
+
+class sim_parameters;
+class param_image;
+
+namespace pvt {
+struct param_directive;
+struct param_file;
+class param_include_graph;
+}
+
+/**
+ * The subspaces of one scope, kept in a vector sorted by name. A lookup
+ * by string_ref is a binary search over contiguous memory and never
+ * builds a std::string. Scopes have few subspaces and only gain them
+ * while parsing, so inserting in the middle is cheap.
+ */
+class namespace_table
+{
+ public:
+  typedef std::pair<std::string, sim_parameters*> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+  iterator begin() { return entries_.begin(); }
+  const_iterator begin() const { return entries_.begin(); }
+
+  iterator end() { return entries_.end(); }
+  const_iterator end() const { return entries_.end(); }
+
+  size_t
+  size() const {
+    return entries_.size();
+  }
+
+  iterator
+  find(string_ref name) {
+    iterator it = lower_bound(name);
+    return (it != entries_.end() && string_ref(it->first) == name) ? it : entries_.end();
+  }
+
+  const_iterator
+  find(string_ref name) const {
+    return const_cast<namespace_table*>(this)->find(name);
+  }
+
+  /**
+   * @return The entry for name, inserted as null if not present
+   */
+  sim_parameters*&
+  operator[](string_ref name) {
+    iterator it = lower_bound(name);
+    if (it == entries_.end() || string_ref(it->first) != name){
+      it = entries_.insert(it, value_type(name.str(), (sim_parameters*) 0));
+    }
+    return it->second;
+  }
+
+ private:
+  struct name_less {
+    bool
+    operator()(const value_type& entry, string_ref name) const {
+      return string_ref(entry.first) < name;
+    }
+  };
+
+  iterator
+  lower_bound(string_ref name) {
+    return std::lower_bound(entries_.begin(), entries_.end(), name, name_less());
+  }
+
+  std::vector<value_type> entries_;
+
+};
+
 class sim_parameters  {
 
  public:
   typedef spkt_unordered_map<std::string, std::string> key_value_map;
+  typedef spkt_unordered_map<uint32_t, std::string> id_value_map;
+  typedef param_iterator<id_value_map::iterator, std::string> iterator;
+  typedef param_iterator<id_value_map::const_iterator, const std::string> const_iterator;
+
   sim_parameters();
 
   sim_parameters(const key_value_map& p);
@@ -101,34 +273,52 @@ class sim_parameters  {
   virtual ~sim_parameters();
 
   void
-  remove_param(const std::string &key);
+  remove_param(const param_key& key);
+
+  /**
+   * Look a parameter up in this namespace and, failing that, in each
+   * enclosing namespace in turn. Each scope costs one probe and nothing
+   * is copied.
+   * @return The stored value, or null if no scope defines the parameter.
+   *         The pointer is invalidated by any write to the scope holding it.
+   */
+  const std::string*
+  find_param(const param_key& key) const;
+
+  /**
+   * As find_param, but only this namespace is probed, never an
+   * enclosing one. has_param and copy_optional_param are local in
+   * the same way, while the optional getters inherit.
+   */
+  const std::string*
+  find_local_param(const param_key& key) const;
 
   std::string
-  get_param(const std::string& key) ;
+  get_param(const param_key& key) ;
 
   std::string
-  reread_param(const std::string& key) {
+  reread_param(const param_key& key) {
     return get_param(key);
   }
 
   std::string
-  reread_optional_param(const std::string& key, const std::string& def) {
+  reread_optional_param(const param_key& key, const std::string& def) {
     return get_optional_param(key, def);
   }
 
   /// Return the value of the keyword if it exists. Otherwise return
   /// a default value.
   /// @param key gives the keyword
-  /// @param def gives the default value (used if has_param(key) is false)
+  /// @param def gives the default value (used if find_param(key) is null)
   /// @return the value if it exists, otherwise the default
   std::string
-  get_optional_param(const std::string &key, const std::string &def);
+  get_optional_param(const param_key& key, const std::string &def);
 
   std::string
-  deprecated_optional_param(const std::string &key, const std::string &def);
+  deprecated_optional_param(const param_key& key, const std::string &def);
 
   std::string
-  deprecated_param(const std::string& key);
+  deprecated_param(const param_key& key);
 
   void
   add_param(const std::string& key, const std::string& val);
@@ -136,6 +326,10 @@ class sim_parameters  {
   void
   copy_param(const std::string& oldname, const std::string& newname);
 
+  /**
+   * Copy oldname to newname if oldname is defined in this namespace
+   * itself. A value inherited from an enclosing namespace is not copied.
+   */
   void
   copy_optional_param(const std::string& oldname, const std::string& newname);
 
@@ -170,57 +364,57 @@ class sim_parameters  {
   }
 
   bool
-  has_param(const std::string& key) const;
+  has_param(const param_key& key) const;
 
   int
-  get_int_param(const std::string& key);
+  get_int_param(const param_key& key);
 
   int
-  deprecated_int_param(const std::string& key);
+  deprecated_int_param(const param_key& key);
 
   int
-  deprecated_optional_int_param(const std::string &key, int def);
+  deprecated_optional_int_param(const param_key& key, int def);
 
   int
-  reread_int_param(const std::string& key);
+  reread_int_param(const param_key& key);
 
   int
-  reread_optional_int_param(const std::string& key, int def);
+  reread_optional_int_param(const param_key& key, int def);
 
   /// Return the value of the keyword if it exists. Otherwise return
   /// a default value.
   /// @param key gives the keyword
-  /// @param def gives the default value (used if has_param(key) is false)
+  /// @param def gives the default value (used if find_param(key) is null)
   /// @return the value if it exists, otherwise the default
   int
-  get_optional_int_param(const std::string &key, int def);
+  get_optional_int_param(const param_key& key, int def);
 
   /// Returns the value of the key as a boolean.
   bool
-  get_bool_param(const std::string &key);
+  get_bool_param(const param_key& key);
 
   bool
-  reread_bool_param(const std::string& key);
+  reread_bool_param(const param_key& key);
 
   bool
-  deprecated_bool_param(const std::string& key);
+  deprecated_bool_param(const param_key& key);
 
   bool
-  deprecated_optional_bool_param(const std::string& key, bool def);
+  deprecated_optional_bool_param(const param_key& key, bool def);
 
   bool
-  reread_optional_bool_param(const std::string& key, bool def);
+  reread_optional_bool_param(const param_key& key, bool def);
 
   /// Return the value of the keyword if it exists. Otherwise return
   /// a default value.
   /// @param key gives the keyword
-  /// @param def gives the default value (used if has_param(key) is false)
+  /// @param def gives the default value (used if find_param(key) is null)
   /// @return the value if it exists, otherwise the default
   bool
-  get_optional_bool_param(const std::string &key, int def);
+  get_optional_bool_param(const param_key& key, int def);
 
   double
-  get_bandwidth_param(const std::string& key);
+  get_bandwidth_param(const param_key& key);
 
   /**
    @param key The parameter name
@@ -229,121 +423,121 @@ class sim_parameters  {
            of B/s, s, Hz, etc
   */
   double
-  get_quantity(const std::string& key);
+  get_quantity(const param_key& key);
 
   double
-  get_optional_quantity(const std::string& key, double def);
+  get_optional_quantity(const param_key& key, double def);
 
   double
-  deprecated_bandwidth_param(const std::string& key);
+  deprecated_bandwidth_param(const param_key& key);
 
   double
-  reread_bandwidth_param(const std::string& key);
+  reread_bandwidth_param(const param_key& key);
 
   double
-  reread_optional_bandwidth_param(const std::string& key, double def);
+  reread_optional_bandwidth_param(const param_key& key, double def);
 
   double
-  deprecated_optional_bandwidth_param(const std::string& key, double def);
+  deprecated_optional_bandwidth_param(const param_key& key, double def);
 
   double
-  get_optional_bandwidth_param(const std::string &key, double def);
+  get_optional_bandwidth_param(const param_key& key, double def);
 
   double
   get_optional_bandwidth_param(
-    const std::string& key,
+    const param_key& key,
     const std::string& def);
 
   long
-  get_byte_length_param(const std::string& key);
+  get_byte_length_param(const param_key& key);
 
   long
-  get_optional_byte_length_param(const std::string& key, long def);
+  get_optional_byte_length_param(const param_key& key, long def);
 
   long
-  deprecated_byte_length_param(const std::string& key);
+  deprecated_byte_length_param(const param_key& key);
 
   long
-  deprecated_optional_byte_length_param(const std::string& key, long def);
+  deprecated_optional_byte_length_param(const param_key& key, long def);
 
   double
-  get_optional_freq_param(const std::string& key, double def);
+  get_optional_freq_param(const param_key& key, double def);
 
   double
-  get_freq_param(const std::string& key);
+  get_freq_param(const param_key& key);
 
   double
-  deprecated_freq_param(const std::string& key);
+  deprecated_freq_param(const param_key& key);
 
   double
-  deprecated_optional_freq_param(const std::string& key, double def);
+  deprecated_optional_freq_param(const param_key& key, double def);
 
   /// Return the value of the keyword if it exists. Otherwise return
   /// a default value.
   /// @param key gives the keyword
-  /// @param def gives the default value (used if has_param(key) is false)
+  /// @param def gives the default value (used if find_param(key) is null)
   /// @return the value if it exists, otherwise the default
   long
-  get_optional_long_param(const std::string &key, long def);
+  get_optional_long_param(const param_key& key, long def);
 
   long
-  get_long_param(const std::string& key);
+  get_long_param(const param_key& key);
 
   long
-  deprecated_long_param(const std::string& key);
+  deprecated_long_param(const param_key& key);
 
   long
-  deprecated_optional_long_param(const std::string& key, long def);
+  deprecated_optional_long_param(const param_key& key, long def);
 
   long
-  reread_long_param(const std::string& key);
+  reread_long_param(const param_key& key);
 
   void
-  reread_optional_long_param(const std::string& key);
+  reread_optional_long_param(const param_key& key);
 
   double
-  get_double_param(const std::string& key);
+  get_double_param(const param_key& key);
 
   /// Return the value of the keyword if it exists. Otherwise return
   /// a default value.
   /// @param key gives the keyword
-  /// @param def gives the default value (used if has_param(key) is false)
+  /// @param def gives the default value (used if find_param(key) is null)
   /// @return the value if it exists, otherwise the default
   double
-  get_optional_double_param(const std::string &key, double def);
+  get_optional_double_param(const param_key& key, double def);
 
   double
-  reread_double_param(const std::string& key);
+  reread_double_param(const param_key& key);
 
   double
-  reread_optional_double_param(const std::string &key, double def);
+  reread_optional_double_param(const param_key& key, double def);
 
   double
-  deprecated_double_param(const std::string& key);
+  deprecated_double_param(const param_key& key);
 
   double
-  deprecated_optional_double_param(const std::string& key, double def);
+  deprecated_optional_double_param(const param_key& key, double def);
 
   double
-  get_time_param(const std::string& key);
+  get_time_param(const param_key& key);
 
   double
-  get_optional_time_param(const std::string &key, double def);
+  get_optional_time_param(const param_key& key, double def);
 
   double
-  deprecated_optional_time_param(const std::string &key, double def);
+  deprecated_optional_time_param(const param_key& key, double def);
 
   double
-  deprecated_time_param(const std::string& key);
+  deprecated_time_param(const param_key& key);
 
   void
-  get_vector_param(const std::string& key, std::vector<int>& vals);
+  get_vector_param(const param_key& key, std::vector<int>& vals);
 
   void
-  get_vector_param(const std::string& key, std::vector<double>& vals);
+  get_vector_param(const param_key& key, std::vector<double>& vals);
 
   void
-  get_vector_param(const std::string& key, std::vector<std::string>& vals);
+  get_vector_param(const param_key& key, std::vector<std::string>& vals);
 
   sim_parameters*
   get_namespace(const std::string& ns) const;
@@ -359,9 +553,28 @@ class sim_parameters  {
   void
   parse_file(const std::string& fname, bool fail_on_existing = false);
 
+  /**
+   * Same result as parse_file, but fname and the files it includes are
+   * read and their keywords validated on several threads. They are then
+   * applied in include order on the calling thread, so later files still
+   * override earlier ones. Without C++11 this is parse_file.
+   * @param nthreads 0 for one thread per core
+   */
+  void
+  parse_file_parallel(const std::string& fname, int nthreads = 0,
+                      bool fail_on_existing = false);
+
   void
   parse_stream(std::istream& in, bool fail_on_existing = false);
 
+  /**
+   * Parse the contents of a parameter file held in memory. Lines are
+   * scanned in place, and a key or value is only copied into a string
+   * when it is stored.
+   */
+  void
+  parse_text(string_ref text, bool fail_on_existing = false);
+
   void
   parse_line(const std::string& line, bool fail_on_existing = false);
 
@@ -371,7 +584,7 @@ class sim_parameters  {
     @param fail_on_existing Fail if the parameter named by key already exists
   */
   void
-  parse_keyval(const std::string& key, const std::string& value,
+  parse_keyval(string_ref key, const std::string& value,
     bool fail_on_existing);
 
   param_assign
@@ -380,28 +593,165 @@ class sim_parameters  {
   const sim_parameters*
   top_parent() const;
 
-  key_value_map::iterator begin() { return params_.begin(); }
-  key_value_map::const_iterator begin() const { return params_.begin(); }
+  /**
+   * Compile the whole tree this namespace belongs to into one param_image.
+   * Afterwards every lookup anywhere in the tree is served from the image,
+   * no value cache is written, and adding, overriding or removing a parameter
+   * throws, as does taking a non-const iterator. The read API can then
+   * be used from many threads at once.
+   */
+  void
+  freeze();
+
+  bool
+  is_frozen() const {
+    return frozen_;
+  }
+
+  /** Bumped whenever the layout written by save_image changes */
+  static const uint32_t image_version = 2;
+
+  /**
+   * Write the whole tree to a binary image. The tree is stored fully
+   * resolved, with includes already read and variables expanded. The image
+   * also records the size, mtime and content hash of every file parsed
+   * into the tree, so that a stale image can be detected, and which of them
+   * was parsed first, the root. The image is written to a temporary file
+   * and renamed into place, so a concurrent reader sees either the old
+   * image or the whole new one.
+   */
+  void
+  save_image(const std::string& image_file) const;
+
+  /**
+   * Add the tree stored in an image to this one, without parsing.
+   * Keywords are only validated if they were not when the image was saved.
+   * @param check_sources Refuse an image if any of its source files has
+   *                      changed size, mtime or contents since it was saved
+   * @param root If not empty, refuse an image built from another root file
+   * @return False if the image is missing, from another image_version,
+   *         stale, built from another root or corrupt. The tree is
+   *         then left untouched.
+   */
+  bool
+  load_image(const std::string& image_file, bool check_sources = true,
+             const std::string& root = std::string());
+
+  /**
+   * Load fname from image_file if the image is up to date with fname
+   * and everything it includes. Otherwise parse fname and rewrite the image.
+   */
+  void
+  parse_file_cached(const std::string& fname, const std::string& image_file,
+                    bool fail_on_existing = false);
+
+  /**
+   * @return Every file parsed into this tree, in the order first read
+   */
+  const std::vector<std::string>&
+  source_files() const {
+    return source_files_;
+  }
+
+  /**
+   * @return A counter that changes whenever any parameter is written,
+   *         for callers that cache values read from parameters
+   */
+  static unsigned long
+  write_generation() {
+    return __atomic_load_n(&generation_, __ATOMIC_ACQUIRE);
+  }
+
+  /**
+   * The caller may write through it->second, so taking a non-const
+   * iterator counts as a write: it throws on a frozen tree and
+   * invalidates cached values. Use const_iterator to only read.
+   */
+  iterator begin();
+  const_iterator begin() const { return params_.begin(); }
 
-  key_value_map::iterator end() { return params_.end(); }
-  key_value_map::const_iterator end() const { return params_.end(); }
+  iterator end() { return params_.end(); }
+  const_iterator end() const { return params_.end(); }
 
-  typedef std::map<std::string, sim_parameters*>::iterator namespace_iterator;
-  typedef std::map<std::string, sim_parameters*>::const_iterator const_namespace_iterator;
+  typedef namespace_table::iterator namespace_iterator;
+  typedef namespace_table::const_iterator const_namespace_iterator;
   namespace_iterator ns_begin() { return subspaces_.begin(); }
   const_namespace_iterator ns_begin() const { return subspaces_.begin(); }
   namespace_iterator ns_end() { return subspaces_.end(); }
   const_namespace_iterator ns_end() const { return subspaces_.end(); }
 
  protected:
-  std::map<std::string, sim_parameters*> subspaces_;
+  friend class param_assign;
+
+  typedef enum {
+    time_units,
+    bandwidth_units,
+    freq_units,
+    byte_length_units,
+    quantity_units
+  } units_type;
+
+  /**
+   * The parsed value of a unit-bearing parameter. Any write anywhere in
+   * any parameter tree bumps the global generation, which invalidates every
+   * cached value at once, including values inherited from a parent scope.
+   * Getters are const but fill the cache, so it is guarded by cache_lock_
+   * and const reads may run on many threads at once. Writes still need the
+   * tree to themselves.
+   */
+  struct cached_value {
+    unsigned long generation;
+    units_type units;
+    double value;
+  };
+
+  typedef spkt_unordered_map<uint32_t, cached_value> value_cache;
+
+  mutable value_cache cache_;
+
+  mutable int cache_lock_;
+
+  static unsigned long generation_;
+
+  static void
+  invalidate_caches() {
+    __atomic_add_fetch(&generation_, 1, __ATOMIC_RELEASE);
+  }
+
+  void
+  lock_cache() const {
+    while (__atomic_test_and_set(&cache_lock_, __ATOMIC_ACQUIRE)) ;
+  }
+
+  void
+  unlock_cache() const {
+    __atomic_clear(&cache_lock_, __ATOMIC_RELEASE);
+  }
+
+  bool
+  get_cached(const param_key& key, units_type units, double& val) const;
+
+  void
+  set_cached(const param_key& key, units_type units, double val) const;
+
+  namespace_table subspaces_;
   std::map<std::string, std::string> variables_;
 
+  /** Only kept on the top scope */
+  std::vector<std::string> source_files_;
+
   sim_parameters* parent_;
 
   static sim_parameters* empty_ns_params_;
 
-  key_value_map params_;
+  /** Values by param_key id */
+  id_value_map params_;
+
+  /** Once frozen, the image of the whole tree, owned by the top scope */
+  param_image* frozen_;
+
+  /** This namespace's scope number in frozen_ */
+  uint32_t frozen_scope_;
 
   sim_parameters*
   subspace_clone() {
@@ -419,26 +769,60 @@ class sim_parameters  {
   }
 
   void
-  split_line(const std::string& line, std::pair<std::string, std::string>& p);
+  split_line(string_ref line, string_ref& key, string_ref& value);
+
+  void
+  parse_directive(string_ref line, bool fail_on_existing);
+
+  void
+  apply_directive(const pvt::param_directive& d, bool fail_on_existing,
+                  bool validate);
+
+  void
+  replay(const pvt::param_include_graph& graph, pvt::param_file* f,
+         bool fail_on_existing);
 
   void
   try_to_parse(const std::string& fname, bool fail_on_existing = false);
 
   void
-  print_params(const key_value_map& pmap, std::ostream& os, bool pretty_print, std::list<std::string>& ns) const;
+  print_params(const id_value_map& pmap, std::ostream& os, bool pretty_print, std::list<std::string>& ns) const;
 
   void
-  do_add_param(const std::string& key, const std::string& val,
-    bool fail_on_existing);
+  do_add_param(const param_key& key, const std::string& val,
+    bool fail_on_existing, bool validate = true);
 
   sim_parameters*
-  get_param_scope(const std::string& ns);
+  get_param_scope(string_ref ns);
 
-  std::string
-  go_get_param(const std::string &key, bool throw_on_error = true) const;
+  void
+  check_not_frozen(const std::string& key) const;
+
+  void
+  compile_into(param_image* image, uint32_t parent_scope);
+
+  void
+  add_source_file(const std::string& path);
+
+  void
+  pack_image(serializer& ser) const;
+
+  /**
+   * Every read is bounds checked, whatever the serialization policy.
+   * @param apply If false, only decode (and validate) without
+   *              writing anything
+   */
+  void
+  unpack_image(serializer& ser, bool validate, bool apply);
+
+  /**
+   * As find_param, but a missing parameter is an error
+   */
+  const std::string&
+  require_param(const param_key& key) const;
 
   sim_parameters*
-  get_scope_and_key(const std::string& key, std::string& final_key);
+  get_scope_and_key(string_ref key, string_ref& final_key);
 
 };
 
@@ -0,0 +1,204 @@
+#ifndef SPROCKIT_STRING_REF_H
+#define SPROCKIT_STRING_REF_H
+
+#include <sprockit/spkt_config.h>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+
+namespace sprockit {
+
+/**
+ * A non-owning view of a run of characters, for splitting and looking up
+ * keys without allocating a std::string per piece. The characters must
+ * outlive the view.
+ */
+class string_ref
+{
+ public:
+  static const size_t npos = ~size_t(0);
+
+  string_ref() :
+    data_(0), size_(0)
+  {
+  }
+
+  string_ref(const char* str) :
+    data_(str), size_(::strlen(str))
+  {
+  }
+
+  string_ref(const std::string& str) :
+    data_(str.data()), size_(str.size())
+  {
+  }
+
+  string_ref(const char* data, size_t size) :
+    data_(data), size_(size)
+  {
+  }
+
+  const char*
+  data() const {
+    return data_;
+  }
+
+  size_t
+  size() const {
+    return size_;
+  }
+
+  bool
+  empty() const {
+    return size_ == 0;
+  }
+
+  const char*
+  begin() const {
+    return data_;
+  }
+
+  const char*
+  end() const {
+    return data_ + size_;
+  }
+
+  char
+  operator[](size_t i) const {
+    return data_[i];
+  }
+
+  size_t
+  find(char c, size_t pos = 0) const {
+    if (pos >= size_) return npos;
+    const void* hit = ::memchr(data_ + pos, c, size_ - pos);
+    return hit ? size_t(static_cast<const char*>(hit) - data_) : npos;
+  }
+
+  size_t
+  find(string_ref str, size_t pos = 0) const {
+    if (str.size_ == 0) return pos <= size_ ? pos : npos;
+    while (pos + str.size_ <= size_){
+      size_t hit = find(str.data_[0], pos);
+      if (hit == npos || hit + str.size_ > size_) return npos;
+      if (::memcmp(data_ + hit, str.data_, str.size_) == 0) return hit;
+      pos = hit + 1;
+    }
+    return npos;
+  }
+
+  size_t
+  rfind(char c) const {
+    for (size_t i=size_; i > 0; --i){
+      if (data_[i-1] == c) return i-1;
+    }
+    return npos;
+  }
+
+  string_ref
+  substr(size_t pos, size_t n = npos) const {
+    if (pos > size_) pos = size_;
+    if (n > size_ - pos) n = size_ - pos;
+    return string_ref(data_ + pos, n);
+  }
+
+  bool
+  starts_with(string_ref prefix) const {
+    return prefix.size_ <= size_
+      && ::memcmp(data_, prefix.data_, prefix.size_) == 0;
+  }
+
+  /**
+   * @return The view without leading and trailing whitespace
+   */
+  string_ref
+  trim() const {
+    const char* first = data_;
+    const char* last = data_ + size_;
+    while (first != last && is_space(*first)) ++first;
+    while (last != first && is_space(*(last-1))) --last;
+    return string_ref(first, last - first);
+  }
+
+  int
+  compare(string_ref other) const {
+    size_t n = size_ < other.size_ ? size_ : other.size_;
+    int cmp = n ? ::memcmp(data_, other.data_, n) : 0;
+    if (cmp != 0) return cmp;
+    if (size_ == other.size_) return 0;
+    return size_ < other.size_ ? -1 : 1;
+  }
+
+  std::string
+  str() const {
+    return std::string(data_, size_);
+  }
+
+  /**
+   * FNV-1a, the same for a view and for a std::string with equal contents
+   */
+  size_t
+  hash() const {
+    size_t h = size_t(14695981039346656037ULL);
+    for (size_t i=0; i < size_; ++i){
+      h ^= (unsigned char) data_[i];
+      h *= size_t(1099511628211ULL);
+    }
+    return h;
+  }
+
+ private:
+  static bool
+  is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  const char* data_;
+  size_t size_;
+
+};
+
+inline bool
+operator==(string_ref a, string_ref b){
+  return a.size() == b.size() && ::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+inline bool
+operator!=(string_ref a, string_ref b){
+  return !(a == b);
+}
+
+inline bool
+operator<(string_ref a, string_ref b){
+  return a.compare(b) < 0;
+}
+
+inline std::ostream&
+operator<<(std::ostream& os, string_ref str){
+  os.write(str.data(), str.size());
+  return os;
+}
+
+//for boost::unordered containers
+inline size_t
+hash_value(string_ref str){
+  return str.hash();
+}
+
+}
+
+#if SPKT_HAVE_CPP11
+#include <functional>
+namespace std {
+template <>
+struct hash<sprockit::string_ref> {
+  size_t
+  operator()(sprockit::string_ref str) const {
+    return str.hash();
+  }
+};
+}
+#endif
+
+#endif // SPROCKIT_STRING_REF_H
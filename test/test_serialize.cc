@@ -1,6 +1,18 @@
 #include <sprockit/test/test.h>
 #include <sprockit/serialize.h>
 #include <sprockit/serializable.h>
+#include <sprockit/serialize_arena.h>
+#include <sprockit/serialize_batch.h>
+#include <sprockit/serialize_stats.h>
+#include <sprockit/serialize_static.h>
+#include <sprockit/shm_ring.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#if SPKT_HAVE_CPP11
+#include <atomic>
+#include <thread>
+#endif
 
 using namespace sprockit;
 
@@ -86,10 +98,45 @@ void overpack_buffer()
   ser & doesntfit;
 }
 
+template <class Container>
+void underpack_container()
+{
+  Container input(100, 7);
+  serializer ser;
+  ser.start_sizing();
+  ser & input;
+  std::vector<char> buf(ser.size());
+  ser.start_packing(&buf[0], buf.size());
+  ser & input;
+
+  //the element count claims more than the truncated buffer holds
+  Container output;
+  ser.start_unpacking(&buf[0], buf.size() / 2);
+  ser & output;
+}
+
+template <class Container>
+void overpack_container()
+{
+  Container input(100, 7);
+  char buf[256];
+  serializer ser;
+  ser.start_packing(buf, sizeof(buf));
+  ser & input;
+}
+
 void test_serialize_overrun(UnitTest& unit)
 {
   assertThrows(unit, "overrun exception", sprockit::pvt::ser_buffer_overrun,
     static_fxn(overpack_buffer));
+  assertThrows(unit, "vector underpack exception", sprockit::pvt::ser_buffer_overrun,
+    static_fxn(underpack_container<std::vector<double> >));
+  assertThrows(unit, "list underpack exception", sprockit::pvt::ser_buffer_overrun,
+    static_fxn(underpack_container<std::list<int> >));
+  assertThrows(unit, "vector overpack exception", sprockit::pvt::ser_buffer_overrun,
+    static_fxn(overpack_container<std::vector<long> >));
+  assertThrows(unit, "deque overpack exception", sprockit::pvt::ser_buffer_overrun,
+    static_fxn(overpack_container<std::deque<long> >));
 }
 
 void insert(std::set<int>& s, int* start, int* stop){ s.insert(start, stop); }
@@ -210,6 +257,120 @@ class B : public Base,
 };
 DeclareSerializable(B)
 
+class C
+#if SPKT_HAVE_CPP11
+ final
+#endif
+ : public Base,
+ public final_serializable_type<C>
+{
+  ImplementSerializable(C)
+ public:
+  std::string name() const { return "C"; }
+};
+DeclareSerializable(C)
+
+class Faulty : public Base,
+ public serializable_type<Faulty>
+{
+  ImplementSerializable(Faulty)
+ public:
+  std::string name() const { return "Faulty"; }
+
+  void serialize_order(serializer& ser){
+    Base::serialize_order(ser);
+    if (ser.mode() == serializer::UNPACK){
+      spkt_throw(value_error, "Faulty: refusing to unpack");
+    }
+  }
+};
+DeclareSerializable(Faulty)
+
+static uint32_t
+runtime_hash(const char* key)
+{
+  uint32_t hash = 0;
+  for (const char* c=key; *c; ++c){
+    hash += *c;
+    hash += (hash << 10);
+    hash ^= (hash >> 6);
+  }
+  hash += (hash << 3);
+  hash ^= (hash >> 11);
+  hash += (hash << 15);
+  return hash;
+}
+
+static const char*
+name_for_id(uint32_t cls_id)
+{
+#if SPKT_HAVE_CPP11
+  switch (cls_id){
+    case SerializableId(A): return "A";
+    case SerializableId(B): return "B";
+    case SerializableId(C): return "C";
+  }
+#endif
+  return "";
+}
+
+void
+test_serializable_id(UnitTest& unit)
+{
+  A a; B b; C c;
+  assertEqual(unit, "class id A", a.cls_id(), runtime_hash("(A)"));
+  assertEqual(unit, "class id B", b.cls_id(), runtime_hash("(B)"));
+  assertEqual(unit, "class id macro", uint32_t(SerializableId(C)), c.cls_id());
+#if SPKT_HAVE_CPP11
+  assertEqual(unit, "class id switch", std::string(name_for_id(b.cls_id())), std::string("B"));
+#endif
+}
+
+void
+test_final_serializable(UnitTest& unit)
+{
+  C* input = new C;
+  serializer ser;
+  char buffer[512];
+
+  ser.start_sizing();
+  ser & input;
+  size_t final_size = ser.size();
+
+  Base* base_input = input;
+  ser.start_sizing();
+  ser & base_input;
+  assertEqual(unit, "final sizer size", final_size, ser.size());
+
+  ser.start_packing(buffer, sizeof(buffer));
+  ser & input;
+
+  ser.start_unpacking(buffer, sizeof(buffer));
+  C* output = 0;
+  ser & output;
+  assertEqual(unit, "final class name", output->name(), std::string("C"));
+  assertEqual(unit, "final class member", output->x(), input->x());
+
+  //same wire format as the virtual path
+  ser.start_unpacking(buffer, sizeof(buffer));
+  Base* base_output = 0;
+  ser & base_output;
+  assertEqual(unit, "final as base class name", base_output->name(), std::string("C"));
+
+  ser.start_packing(buffer, sizeof(buffer));
+  ser & base_input;
+  ser.start_unpacking(buffer, sizeof(buffer));
+  ser & output;
+  assertEqual(unit, "base as final class name", output->name(), std::string("C"));
+
+  C* null_input = 0;
+  ser.start_packing(buffer, sizeof(buffer));
+  ser & null_input;
+  ser.start_unpacking(buffer, sizeof(buffer));
+  ser & output;
+  assertTrue(unit, "final null pointer", output == 0);
+}
+
 void
 test_serializable(UnitTest& unit)
 {
@@ -238,19 +399,760 @@ test_serializable(UnitTest& unit)
   assertEqual(unit, "serialized class member", output->x(), input->x());
 }
 
+void
+test_serialize_arena(UnitTest& unit)
+{
+  ser_arena arena(1024);
+  serializer ser;
+  char buffer[512];
+
+  Base* input = new A;
+  C* final_input = new C;
+  char bytes[40];
+  for (int i=0; i < sizeof(bytes); ++i) bytes[i] = i;
+  int nbytes = sizeof(bytes);
+  void* input_buf = bytes;
+  ser.start_packing(buffer, sizeof(buffer));
+  ser & input;
+  ser & final_input;
+  ser & sprockit::buffer(input_buf, nbytes);
+
+  for (int i=0; i < 3; ++i){
+    Base* output = 0;
+    C* final_output = 0;
+    void* output_buf = 0;
+    int output_size = 0;
+    ser.start_unpacking(buffer, sizeof(buffer), &arena);
+    ser & output;
+    ser & final_output;
+    ser & sprockit::buffer(output_buf, output_size);
+
+    assertEqual(unit, "arena class name", output->name(), std::string("A"));
+    assertEqual(unit, "arena final class name", final_output->name(), std::string("C"));
+    assertEqual(unit, "arena buffer size", output_size, nbytes);
+    assertTrue(unit, "arena owns object", arena.owns(output));
+    assertTrue(unit, "arena owns final object", arena.owns(final_output));
+    assertTrue(unit, "arena owns buffer", arena.owns(output_buf));
+    assertTrue(unit, "arena buffer contents",
+               ::memcmp(output_buf, input_buf, nbytes) == 0);
+    arena.clear();
+  }
+
+  //allocations larger than half a block get their own memory
+  void* big = arena.allocate(4096);
+  assertTrue(unit, "arena owns large block", arena.owns(big));
+  arena.clear();
+  assertTrue(unit, "arena released large block", !arena.owns(big));
+
+  Base* output = 0;
+  ser.start_unpacking(buffer, sizeof(buffer));
+  ser & output;
+  assertTrue(unit, "no arena heap object", !arena.owns(output));
+  delete output;
+}
+
+#if SPKT_SERIALIZE_STATS
+void
+test_serialize_stats(UnitTest& unit)
+{
+  serialize_stats::clear();
+  Base* input = new A;
+  C* final_input = new C;
+  serializer ser;
+  char buffer[512];
+  ser.start_packing(buffer, sizeof(buffer));
+  ser & input;
+  ser & final_input;
+  ser & input;
+  size_t obj_size = sizeof(long) + sizeof(int);
+
+  Base* output = 0;
+  C* final_output = 0;
+  ser.start_unpacking(buffer, sizeof(buffer));
+  ser & output;
+
+  serialize_stats::entry e;
+  assertTrue(unit, "stats recorded", serialize_stats::totals(input->cls_id(), e));
+  assertEqual(unit, "stats name", std::string(e.name), std::string("A"));
+  assertEqual(unit, "stats pack count", e.pack_count, uint64_t(2));
+  assertEqual(unit, "stats pack bytes", e.pack_bytes, uint64_t(2*obj_size));
+  assertEqual(unit, "stats unpack count", e.unpack_count, uint64_t(1));
+  assertEqual(unit, "stats unpack bytes", e.unpack_bytes, uint64_t(obj_size));
+
+  ser & final_output;
+  assertTrue(unit, "final stats recorded", serialize_stats::totals(final_input->cls_id(), e));
+  assertEqual(unit, "final stats pack count", e.pack_count, uint64_t(1));
+  assertEqual(unit, "final stats unpack count", e.unpack_count, uint64_t(1));
+
+  serialize_stats::clear();
+  assertTrue(unit, "stats cleared", !serialize_stats::totals(input->cls_id(), e));
+
+#if SPKT_HAVE_CPP11
+  //a thread that recorded before the tables were freed starts a fresh table
+  std::atomic<int> step(0);
+  std::thread worker([&]{
+    char buf[64];
+    serializer tser;
+    for (int round=0; round < 2; ++round){
+      while (step.load() != 2*round) ;
+      tser.start_packing(buf, sizeof(buf));
+      tser & input;
+      step.store(2*round + 1);
+    }
+  });
+  while (step.load() != 1) ;
+  serialize_stats::delete_statics();
+  step.store(2);
+  worker.join();
+  assertTrue(unit, "stats after delete", serialize_stats::totals(input->cls_id(), e));
+  assertEqual(unit, "stats after delete count", e.pack_count, uint64_t(1));
+#endif
+}
+#endif
+
+#if SPKT_HAVE_CPP11
+struct link_stats {
+  int id;
+  double busy_time;
+  long bytes;
+  std::string name;
+};
+
+void
+test_serialize_columnar(UnitTest& unit)
+{
+  int nlinks = 10;
+  std::vector<link_stats> input(nlinks);
+  for (int i=0; i < nlinks; ++i){
+    input[i].id = i;
+    input[i].busy_time = i * 0.5;
+    input[i].bytes = 1000L * i;
+    input[i].name = sprockit::printf("link%d", i);
+  }
+
+  serializer ser;
+  ser.start_sizing();
+  ser & columnar(input, &link_stats::id, &link_stats::busy_time, &link_stats::bytes);
+  size_t correct_size = sizeof(size_t) + nlinks*(sizeof(int) + sizeof(double) + sizeof(long));
+  assertEqual(unit, "columnar size", ser.size(), correct_size);
+
+  std::vector<char> buffer(ser.size());
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & columnar(input, &link_stats::id, &link_stats::busy_time, &link_stats::bytes);
+
+  //the first column is contiguous right after the count
+  const int* id_column = reinterpret_cast<const int*>(&buffer[sizeof(size_t)]);
+  assertEqual(unit, "columnar id layout", id_column[nlinks-1], nlinks-1);
+
+  std::vector<link_stats> output;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & columnar(output, &link_stats::id, &link_stats::busy_time, &link_stats::bytes);
+  assertEqual(unit, "columnar count", output.size(), input.size());
+  assertEqual(unit, "columnar id", output[7].id, input[7].id);
+  assertEqual(unit, "columnar busy", output[7].busy_time, input[7].busy_time);
+  assertEqual(unit, "columnar bytes", output[7].bytes, input[7].bytes);
+
+  std::vector<int> ids;
+  std::vector<double> busy;
+  std::vector<long> bytes;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & columns(ids, busy, bytes);
+  assertEqual(unit, "soa count", ids.size(), input.size());
+  assertEqual(unit, "soa busy", busy[3], input[3].busy_time);
+  assertEqual(unit, "soa bytes", bytes[9], input[9].bytes);
+
+  //non-primitive columns go element by element
+  ser.start_sizing();
+  ser & columnar(input, &link_stats::name, &link_stats::id);
+  buffer.resize(ser.size());
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & columnar(input, &link_stats::name, &link_stats::id);
+  std::vector<std::string> names;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & columns(names, ids);
+  assertEqual(unit, "soa name", names[4], input[4].name);
+  assertEqual(unit, "soa id", ids[4], input[4].id);
+}
+#endif
+
+template <class Container>
+void
+test_delta_coded(UnitTest& unit)
+{
+  Container input;
+  for (int i=-3; i < 200; i += (i & 3) + 1){
+    input.insert(input.end(), i);
+  }
+  input.insert(input.end(), 1 << 30);
+
+  serializer ser;
+  ser.start_sizing();
+  ser & delta_coded(input);
+  size_t delta_size = ser.size();
+  ser.start_sizing();
+  ser & input;
+  assertTrue(unit, "delta coded smaller", delta_size * 3 < ser.size());
+
+  std::vector<char> buffer(delta_size);
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & delta_coded(input);
+  assertEqual(unit, "delta packed size", ser.size(), delta_size);
+
+  Container output;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & delta_coded(output);
+  assertEqual(unit, "delta unpacked size", ser.size(), delta_size);
+  assertTrue(unit, "delta round trip", output == input);
+}
+
+void
+test_string_table(UnitTest& unit)
+{
+  const char* names[] = { "node.nic.injection", "node.memory", "switch.link" };
+  std::vector<std::string> input;
+  for (int i=0; i < 30; ++i){
+    input.push_back(names[i % 3]);
+  }
+  std::map<std::string, std::string> kv;
+  kv["node.memory"] = "switch.link";
+  kv["other"] = "node.nic.injection";
+
+  serializer ser;
+  ser.start_sizing();
+  ser & input;
+  size_t plain_size = ser.size();
+
+  ser.enable_string_table(true);
+  ser.start_sizing();
+  ser & input;
+  ser & kv;
+  size_t table_size = ser.size();
+  size_t correct_size = sizeof(size_t) + 27*sizeof(int) + 3*sizeof(int)
+    + ::strlen(names[0]) + ::strlen(names[1]) + ::strlen(names[2])
+    + sizeof(size_t) + 3*sizeof(int) + 5 + sizeof(int);
+  assertEqual(unit, "string table size", table_size, correct_size);
+  assertTrue(unit, "string table smaller", table_size < plain_size);
+
+  std::vector<char> buffer(table_size);
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & input;
+  ser & kv;
+  assertEqual(unit, "string table packed size", ser.size(), table_size);
+
+  std::vector<std::string> output;
+  std::map<std::string, std::string> kv_output;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & output;
+  ser & kv_output;
+  assertEqual(unit, "string table round trip", output, input);
+  assertEqual(unit, "string table map", kv_output["other"], kv["other"]);
+  assertEqual(unit, "string table map", kv_output["node.memory"], kv["node.memory"]);
+}
+
+void
+unpack_corrupt_indexed()
+{
+  size_t buf[4];
+  buf[0] = size_t(-1);
+  std::vector<int> output;
+  serializer ser;
+  ser.start_unpacking((char*) buf, sizeof(buf));
+  ser & indexed(output);
+}
+
+void
+test_indexed(UnitTest& unit)
+{
+  std::vector<std::string> input;
+  std::vector<std::vector<int> > nested;
+  for (int i=0; i < 1000; ++i){
+    input.push_back(std::string(i % 37, 'a' + i % 26));
+    nested.push_back(std::vector<int>(i % 11, i));
+  }
+
+  serializer ser;
+  ser.start_sizing();
+  ser & indexed(input);
+  ser & indexed(nested);
+  std::vector<char> buffer(ser.size());
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & indexed(input);
+  ser & indexed(nested);
+  assertEqual(unit, "indexed packed size", ser.size(), buffer.size());
+
+  std::vector<std::string> output;
+  std::vector<std::vector<int> > nested_output;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & indexed(output);
+  ser & indexed(nested_output);
+  assertEqual(unit, "indexed sequential", output, input);
+  assertTrue(unit, "indexed sequential nested", nested_output == nested);
+
+  output.clear();
+  nested_output.clear();
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & indexed(output, 4);
+  ser & indexed(nested_output, 3);
+  assertEqual(unit, "indexed parallel unpacked size", ser.size(), buffer.size());
+  assertEqual(unit, "indexed parallel", output, input);
+  assertTrue(unit, "indexed parallel nested", nested_output == nested);
+
+  assertThrows(unit, "indexed corrupt count", value_error,
+    static_fxn(unpack_corrupt_indexed));
+}
+
+void
+test_flat_table(UnitTest& unit)
+{
+  enum { node_id, node_name, node_ports, node_nic, node_nfields };
+  enum { nic_bandwidth, nic_latency, nic_nfields };
+
+  flat_builder nic(nic_nfields);
+  nic.add(nic_bandwidth, 10.5e9);
+
+  std::vector<int> ports;
+  for (int i=0; i < 6; ++i) ports.push_back(100 + i);
+  flat_builder node(node_nfields);
+  node.add_string(node_name, "node42");
+  node.add(node_id, 42);
+  node.add_array(node_ports, ports);
+  node.add_table(node_nic, nic);
+  assertThrows(unit, "flat field twice", value_error, member_fxn(&node, &flat_builder::add<int>, 0, 1));
+
+  serializer ser;
+  char tag = 'x';
+  ser.start_sizing();
+  ser & tag;
+  ser & node;
+  std::vector<char> buffer(ser.size());
+  ser.start_packing(&buffer[0], buffer.size());
+  ser & tag;
+  ser & node;
+  assertEqual(unit, "flat packed size", ser.size(), buffer.size());
+
+  flat_table table;
+  ser.start_unpacking(&buffer[0], buffer.size());
+  ser & tag;
+  ser & table;
+  assertTrue(unit, "flat zero copy",
+    table.data() > &buffer[0] && table.data() < &buffer[0] + buffer.size());
+  assertEqual(unit, "flat aligned", (size_t(table.data()) % flat_builder::alignment), size_t(0));
+  assertEqual(unit, "flat id", table.get<int>(node_id), 42);
+  assertEqual(unit, "flat name", table.get_string(node_name), std::string("node42"));
+  size_t nports;
+  const int* port_ptr = table.get_array<int>(node_ports, nports);
+  assertEqual(unit, "flat nports", nports, ports.size());
+  assertEqual(unit, "flat port", port_ptr[5], 105);
+  flat_table nic_table = table.get_table(node_nic);
+  assertEqual(unit, "flat nested", nic_table.get<double>(nic_bandwidth), 10.5e9);
+  assertTrue(unit, "flat absent", !nic_table.has(nic_latency));
+  assertEqual(unit, "flat default", nic_table.get<double>(nic_latency, 1.0), 1.0);
+
+  //tables inside an indexed container decode the same on any worker
+  std::vector<flat_table> tables(40, table);
+  ser.start_sizing();
+  ser & tag;
+  ser & indexed(tables);
+  std::vector<char> indexed_buffer(ser.size());
+  ser.start_packing(&indexed_buffer[0], indexed_buffer.size());
+  ser & tag;
+  ser & indexed(tables);
+  std::vector<flat_table> indexed_tables;
+  ser.start_unpacking(&indexed_buffer[0], indexed_buffer.size());
+  ser & tag;
+  ser & indexed(indexed_tables, 4);
+  assertEqual(unit, "flat indexed count", indexed_tables.size(), tables.size());
+  bool all_aligned = true;
+  for (size_t i=0; i < indexed_tables.size(); ++i){
+    if (size_t(indexed_tables[i].data()) % flat_builder::alignment) all_aligned = false;
+  }
+  assertTrue(unit, "flat indexed aligned", all_aligned);
+  port_ptr = indexed_tables[37].get_array<int>(node_ports, nports);
+  assertEqual(unit, "flat indexed nports", nports, ports.size());
+  assertEqual(unit, "flat indexed port", port_ptr[3], 103);
+  assertEqual(unit, "flat indexed nested",
+    indexed_tables[39].get_table(node_nic).get<double>(nic_bandwidth), 10.5e9);
+
+  //relocatable: a copy somewhere else reads the same
+  std::vector<char> copy(table.data(), table.data() + table.size());
+  flat_table moved(&copy[0], copy.size());
+  assertEqual(unit, "flat relocated", moved.get_table(node_nic).get<double>(nic_bandwidth), 10.5e9);
+
+  //a nested offset past the end of the table is caught, not followed
+  uint32_t bad_offset = copy.size() + 64;
+  ::memcpy(&copy[(node_nic+1)*sizeof(uint32_t)], &bad_offset, sizeof(uint32_t));
+  flat_table corrupt(&copy[0], copy.size());
+  assertThrows(unit, "flat corrupt nested offset", value_error,
+    member_fxn(&corrupt, &flat_table::get_table, int(node_nic)));
+}
+
+void
+test_batch(UnitTest& unit)
+{
+  //start tiny to force the buffer to grow
+  ser_batch_packer packer(8);
+  A a; B b; C c;
+  int nmsgs = 300;
+  for (int i=0; i < nmsgs; ++i){
+    switch (i % 3){
+      case 0: packer.add(&a); break;
+      case 1: packer.add(&b); break;
+      case 2: packer.add(&c); break;
+    }
+  }
+  assertEqual(unit, "batch count", packer.count(), size_t(nmsgs));
+  size_t msg_size = sizeof(long) + sizeof(int);
+  assertEqual(unit, "batch data size", packer.size(), nmsgs*msg_size);
+
+  size_t size;
+  char* buf = packer.finish(size);
+  assertEqual(unit, "batch size", size, nmsgs*(msg_size + sizeof(uint32_t)) + sizeof(uint32_t));
+
+  ser_arena arena;
+  ser_batch_unpacker unpacker(buf, size, &arena);
+  assertEqual(unit, "batch unpack count", unpacker.count(), size_t(nmsgs));
+  Base* msg = static_cast<Base*>(unpacker.get(nmsgs-2));
+  assertEqual(unit, "batch random access", msg->name(), std::string("B"));
+
+  int idx = 0;
+  bool names_match = true;
+  serializable* s;
+  while (unpacker.next(s)){
+    const char* expected = idx % 3 == 0 ? "A" : (idx % 3 == 1 ? "B" : "C");
+    names_match = names_match && static_cast<Base*>(s)->name() == expected;
+    ++idx;
+  }
+  assertEqual(unit, "batch iterate count", idx, nmsgs);
+  assertTrue(unit, "batch iterate order", names_match);
+
+  packer.clear();
+  packer.add(&c);
+  buf = packer.finish(size);
+  ser_batch_unpacker single(buf, size);
+  assertEqual(unit, "batch reuse count", single.count(), size_t(1));
+  Base* out = static_cast<Base*>(single.get(0));
+  assertEqual(unit, "batch reuse", out->name(), std::string("C"));
+  delete out;
+
+  //the first message fills the buffer exactly, the next starts at its end
+  ser_batch_packer exact(msg_size);
+  exact.add(&a);
+  exact.add(&b);
+  buf = exact.finish(size);
+  ser_batch_unpacker exact_unpacker(buf, size);
+  assertEqual(unit, "batch exact fit count", exact_unpacker.count(), size_t(2));
+}
+
+class D : public serializable,
+ public serializable_type<D>
+{
+  ImplementSerializable(D)
+  ImplementStaticSerializeOrder()
+ public:
+  template <class Ser>
+  void
+  serialize_order_t(Ser& ser){
+    ser & id;
+    ser & flag;
+    ser & weight;
+    ser & name;
+    ser & ports;
+    ser & names;
+    ser & counts;
+    ser & ids;
+    ser & child;
+  }
+
+  int id;
+  bool flag;
+  double weight;
+  std::string name;
+  std::vector<int> ports;
+  std::vector<std::string> names;
+  std::map<std::string,long> counts;
+  std::set<int> ids;
+  Base* child;
+};
+DeclareSerializable(D)
+
+void
+test_static_serializer(UnitTest& unit)
+{
+  D input;
+  input.id = 7;
+  input.flag = true;
+  input.weight = 2.5;
+  input.name = "static";
+  for (int i=0; i < 5; ++i){
+    input.ports.push_back(i*i);
+    input.names.push_back(std::string(i, 'z'));
+    input.ids.insert(3*i);
+  }
+  input.counts["a"] = 1;
+  input.counts["b"] = 2;
+  input.child = new B;
+
+  //the same template run through the dynamic serializer gives the reference format
+  serializer ser;
+  ser.start_sizing();
+  input.serialize_order_t(ser);
+  std::vector<char> dynamic_buf(ser.size());
+  ser.start_packing(&dynamic_buf[0], dynamic_buf.size());
+  input.serialize_order_t(ser);
+
+  ser.start_sizing();
+  input.serialize_order(ser);
+  assertEqual(unit, "static size", ser.size(), dynamic_buf.size());
+  std::vector<char> static_buf(ser.size());
+  ser.start_packing(&static_buf[0], static_buf.size());
+  input.serialize_order(ser);
+  assertTrue(unit, "static wire format", static_buf == dynamic_buf);
+
+  D output;
+  ser.start_unpacking(&static_buf[0], static_buf.size());
+  output.serialize_order(ser);
+  assertEqual(unit, "static unpacked size", ser.size(), static_buf.size());
+  assertEqual(unit, "static int", output.id, input.id);
+  assertTrue(unit, "static bool", output.flag);
+  assertEqual(unit, "static double", output.weight, input.weight);
+  assertEqual(unit, "static string", output.name, input.name);
+  assertEqual(unit, "static vector", output.ports, input.ports);
+  assertEqual(unit, "static string vector", output.names, input.names);
+  assertEqual(unit, "static map", output.counts["b"], 2L);
+  assertTrue(unit, "static set", output.ids == input.ids);
+  assertEqual(unit, "static child", output.child->name(), std::string("B"));
+
+  //repeated strings become back-references in both the size and the packing
+  input.names.assign(5, "repeated");
+  ser.enable_string_table(true);
+  ser.start_sizing();
+  input.serialize_order(ser);
+  std::vector<char> table_buf(ser.size());
+  ser.start_packing(&table_buf[0], table_buf.size());
+  input.serialize_order(ser);
+  assertEqual(unit, "static string table size", ser.size(), table_buf.size());
+  D table_output;
+  ser.start_unpacking(&table_buf[0], table_buf.size());
+  table_output.serialize_order(ser);
+  assertEqual(unit, "static string table", table_output.names, input.names);
+}
+
+void
+test_content_hash(UnitTest& unit)
+{
+  D first;
+  first.id = 3;
+  first.flag = false;
+  first.weight = 0.5;
+  first.name = "hash";
+  for (int i=0; i < 4; ++i){
+    first.ports.push_back(i);
+    first.names.push_back("port");
+    first.ids.insert(i);
+  }
+  first.counts["x"] = 10;
+  first.child = new B;
+
+  D second;
+  second.id = first.id;
+  second.flag = first.flag;
+  second.weight = first.weight;
+  second.name = first.name;
+  second.ports = first.ports;
+  second.names = first.names;
+  second.counts = first.counts;
+  second.ids = first.ids;
+  second.child = new B;
+
+  D* ptr = &first;
+  uint64_t h = content_hash(ptr);
+  ptr = &second;
+  assertEqual(unit, "equal objects hash equal", content_hash(ptr), h);
+  assertTrue(unit, "seeded hash differs", content_hash(ptr, 1) != h);
+
+  second.names[2] = "porT";
+  assertTrue(unit, "changed string changes hash", content_hash(ptr) != h);
+  second.names[2] = "port";
+  second.child = new A;
+  assertTrue(unit, "child class changes hash", content_hash(ptr) != h);
+
+  //hashing follows content, not the string table encoding
+  serializer ser;
+  ser.enable_string_table(true);
+  ser.start_hashing();
+  ser & ptr;
+  serializer plain;
+  plain.start_hashing();
+  plain & ptr;
+  assertEqual(unit, "string table hash", ser.digest(), plain.digest());
+
+  std::vector<int> v;
+  for (int i=0; i < 100; ++i) v.push_back(i);
+  uint64_t vh = content_hash(v);
+  std::vector<int> w(v);
+  assertEqual(unit, "vector hash", content_hash(w), vh);
+  w[99] = 0;
+  assertTrue(unit, "vector last element", content_hash(w) != vh);
+  std::vector<int> shorter(v.begin(), v.end() - 1);
+  assertTrue(unit, "vector length", content_hash(shorter) != vh);
+}
+
+void
+mismatched_copy()
+{
+  std::vector<int> src(3, 1);
+  std::vector<double> dst;
+  serializer ser;
+  ser.start_copy_source();
+  ser & src;
+  ser.start_copy_dest();
+  ser & dst;
+}
+
+void
+test_deep_copy(UnitTest& unit)
+{
+  D input;
+  input.id = 11;
+  input.flag = true;
+  input.weight = -1.25;
+  input.name = "original";
+  for (int i=0; i < 6; ++i){
+    input.ports.push_back(100 + i);
+    input.names.push_back(std::string(i + 1, 'c'));
+    input.ids.insert(i * 7);
+  }
+  input.counts["p"] = 4;
+  input.child = new B;
+
+  D* src = &input;
+  D* copy = deep_copy(src);
+  assertTrue(unit, "copy is a new object", copy != src);
+  assertEqual(unit, "copy int", copy->id, input.id);
+  assertTrue(unit, "copy bool", copy->flag);
+  assertEqual(unit, "copy double", copy->weight, input.weight);
+  assertEqual(unit, "copy string", copy->name, input.name);
+  assertEqual(unit, "copy vector", copy->ports, input.ports);
+  assertEqual(unit, "copy string vector", copy->names, input.names);
+  assertTrue(unit, "copy set", copy->ids == input.ids);
+  assertEqual(unit, "copy map", copy->counts["p"], 4L);
+  assertTrue(unit, "copy child is new", copy->child != input.child);
+  assertEqual(unit, "copy child type", copy->child->name(), std::string("B"));
+  assertEqual(unit, "copy hash", content_hash(copy), content_hash(src));
+  assertEqual(unit, "source untouched", input.name, std::string("original"));
+
+  //the static type is only a base class - the factory builds the right one
+  Base* base = copy->child;
+  Base* base_copy = deep_copy(base);
+  assertEqual(unit, "copy through base", base_copy->name(), std::string("B"));
+
+  C* final_obj = new C;
+  C* final_copy = deep_copy(final_obj);
+  assertTrue(unit, "copy final type", final_copy != 0 && final_copy != final_obj);
+  C* null_obj = 0;
+  assertTrue(unit, "copy null", deep_copy(null_obj) == 0);
+
+  std::map<std::string, std::list<double> > values, values_copy;
+  values["x"].push_back(1.5);
+  values["y"].push_back(2.5);
+  values["y"].push_back(3.5);
+  deep_copy(values, values_copy);
+  assertTrue(unit, "copy value type", values_copy == values);
+
+  assertThrows(unit, "copy into mismatched type", value_error,
+    static_fxn(mismatched_copy));
+}
+
+static void
+attach_ring(std::string name)
+{
+  shm_ring ring(name);
+}
+
+void
+test_shm_ring(UnitTest& unit)
+{
+  std::string name = sprockit::printf("/spkt_test_ring_%d", ::getpid());
+  shm_ring producer(name, 256);
+  shm_ring consumer(name);
+
+  assertEqual(unit, "attached capacity", consumer.capacity(), producer.capacity());
+
+  //push enough records through a small ring to wrap around many times
+  for (int i=0; i < 50; ++i){
+    std::vector<int> input(i % 7 + 1, i);
+    std::list<int> input2(i % 5, -i);
+    producer.send(input);
+    producer.send(input2);
+
+    std::vector<int> output;
+    std::list<int> output2;
+    consumer.recv(output);
+    consumer.recv(output2);
+    assertEqual(unit, "ring vector", output, input);
+    assertEqual(unit, "ring list", output2.size(), input2.size());
+  }
+
+  Base* input = new B;
+  producer.send(input);
+  Base* output = 0;
+  consumer.recv(output);
+  assertEqual(unit, "ring class name", output->name(), std::string("B"));
+  assertEqual(unit, "ring class member", output->x(), input->x());
+
+  //a record that fails to unpack is still handed back to the producer
+  Base* faulty = new Faulty;
+  producer.send(faulty);
+  assertThrows(unit, "ring failed recv", value_error,
+    member_fxn(&consumer, &shm_ring::recv<Base*>, output));
+  int after = 42, after_output = 0;
+  producer.send(after);
+  consumer.recv(after_output);
+  assertEqual(unit, "ring after failed recv", after_output, after);
+
+  //a segment cut shorter than its header claims is not a ring
+  int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+  assertTrue(unit, "reopen segment", fd >= 0);
+  assertEqual(unit, "truncate segment", ::ftruncate(fd, sizeof(sprockit::pvt::shm_ring_header) + 64), 0);
+  ::close(fd);
+  assertThrows(unit, "attach truncated ring", value_error,
+    static_fxn(attach_ring, name));
+}
+
 int 
 main(int arc, char** argv)
 {
   UnitTest unit;
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_basic, unit);
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_array, unit);
+#if !SPKT_TRUSTED_SERIALIZATION
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_overrun, unit);
+#endif
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_container<std::list<int> >, unit);
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_container<std::set<int> >, unit);
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_container<std::vector<int> >, unit);
   typedef std::map<std::string, int> STDMap;
   SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_map<STDMap>, unit);
   SPROCKIT_RUN_TEST_NO_ARGS(test_serializable, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_serializable_id, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_final_serializable, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_arena, unit);
+#if SPKT_SERIALIZE_STATS
+  SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_stats, unit);
+#endif
+#if SPKT_HAVE_CPP11
+  SPROCKIT_RUN_TEST_NO_ARGS(test_serialize_columnar, unit);
+#endif
+  SPROCKIT_RUN_TEST_NO_ARGS(test_delta_coded<std::set<int> >, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_delta_coded<std::vector<long> >, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_string_table, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_indexed, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_flat_table, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_batch, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_static_serializer, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_content_hash, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_deep_copy, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_shm_ring, unit);
   return unit.validate(std::cout);
 }
 
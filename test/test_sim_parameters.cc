@@ -0,0 +1,642 @@
+#include <sprockit/test/test.h>
+#include <sprockit/sim_parameters.h>
+#include <sprockit/param_handle.h>
+#include <sprockit/keyword_registration.h>
+#include <sprockit/errors.h>
+#include <sprockit/param_versions.h>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#if SPKT_HAVE_CPP11
+#include <thread>
+#endif
+
+using namespace sprockit;
+
+#if SPKT_HAVE_CPP11
+static void
+read_cached(sim_parameters* params, double expected, bool* same)
+{
+  for (int i=0; i < 1000; ++i){
+    if (params->get_time_param("injection_latency") != expected) *same = false;
+    if (params->get_time_param("latency") <= 0) *same = false;
+  }
+}
+
+
+static void
+intern_names(int thread, bool* consistent)
+{
+  for (int i=0; i < 2000; ++i){
+    std::stringstream sstr;
+    sstr << "interned_" << thread << "_" << i;
+    std::string name = sstr.str();
+    uint32_t id = param_key::intern(name);
+    if (param_key::find(name) != id || param_key::key_name(id) != name){
+      *consistent = false;
+    }
+    //every thread also reads names the others are adding
+    std::stringstream other;
+    other << "interned_" << (thread + 1) % 4 << "_" << i;
+    uint32_t other_id = param_key::find(other.str());
+    if (other_id != param_key::no_id && param_key::key_name(other_id) != other.str()){
+      *consistent = false;
+    }
+  }
+}
+#endif
+
+void
+test_value_cache(UnitTest& unit)
+{
+  sim_parameters params;
+  params.add_param("latency", "2ns");
+  params.add_param("bandwidth", "4GB/s");
+  params.add_param("frequency", "2GHz");
+  params.add_param("size", "8KB");
+  params.add_param("node.injection_latency", "1us");
+
+  double latency = params.get_time_param("latency");
+  assertEqual(unit, "time repeat", params.get_time_param("latency"), latency);
+  assertEqual(unit, "quantity", params.get_quantity("latency"), latency);
+
+  double bw = params.get_bandwidth_param("bandwidth");
+  assertEqual(unit, "bandwidth repeat", params.get_bandwidth_param("bandwidth"), bw);
+  double freq = params.get_freq_param("frequency");
+  assertEqual(unit, "freq repeat", params.get_freq_param("frequency"), freq);
+  long size = params.get_byte_length_param("size");
+  assertEqual(unit, "byte length repeat", params.get_byte_length_param("size"), size);
+
+  params.add_param_override("latency", "4ns");
+  assertEqual(unit, "time after override", params.get_time_param("latency"), 2*latency);
+  assertEqual(unit, "quantity after override", params.get_quantity("latency"), 2*latency);
+
+  params["bandwidth"] = "8GB/s";
+  assertEqual(unit, "bandwidth after assign", params.get_bandwidth_param("bandwidth"), 2*bw);
+
+  //a child scope caches values it inherits - they must follow the parent
+  sim_parameters* node = params.get_namespace("node");
+  assertEqual(unit, "inherited freq", node->get_freq_param("frequency"), freq);
+  params.add_param_override("frequency", "1GHz");
+  assertEqual(unit, "inherited freq after override",
+              node->get_freq_param("frequency"), freq/2);
+
+  params.remove_param("size");
+  assertEqual(unit, "optional after remove",
+              params.get_optional_byte_length_param("size", 7), 7L);
+  assertEqual(unit, "optional default",
+              params.get_optional_bandwidth_param("missing", 2.5), 2.5);
+  assertEqual(unit, "optional present",
+              params.get_optional_bandwidth_param("bandwidth", 2.5), 2*bw);
+
+#if SPKT_HAVE_CPP11
+  //const reads fill the cache from several threads at once
+  double injection = node->get_time_param("injection_latency");
+  bool same[4] = { true, true, true, true };
+  std::vector<std::thread> readers;
+  for (int t=0; t < 4; ++t){
+    readers.push_back(std::thread(read_cached, node, injection, &same[t]));
+  }
+  for (int t=0; t < 4; ++t){
+    readers[t].join();
+  }
+  assertTrue(unit, "concurrent cached reads", same[0] && same[1] && same[2] && same[3]);
+#endif
+}
+
+void
+test_param_key(UnitTest& unit)
+{
+  static const param_key latency_key("latency");
+  param_key same("latency");
+  assertEqual(unit, "interned once", same.id(), latency_key.id());
+  assertTrue(unit, "distinct names", param_key("bandwidth").id() != latency_key.id());
+  assertEqual(unit, "key name", latency_key.name(), std::string("latency"));
+
+  //probing for a name never stored does not add it to the table
+  sim_parameters probed;
+  assertTrue(unit, "probe missing", !probed.has_param("never_stored_anywhere"));
+  assertEqual(unit, "probe optional", probed.get_optional_int_param("never_stored_anywhere", 3), 3);
+  assertEqual(unit, "probe not interned", param_key::find("never_stored_anywhere"), param_key::no_id);
+
+  //a key made before its name is stored finds it once it is
+  static const param_key early_key("stored_later");
+  assertEqual(unit, "early key unresolved", early_key.id(), param_key::no_id);
+  assertEqual(unit, "early key name", early_key.name(), std::string("stored_later"));
+  probed.add_param("stored_later", "4");
+  assertEqual(unit, "early key resolved", probed.get_int_param(early_key), 4);
+  assertEqual(unit, "early key id", early_key.id(), param_key::find("stored_later"));
+
+#if SPKT_HAVE_CPP11
+  //names added from several threads while others look them up,
+  //enough to grow the table more than once
+  bool consistent[4] = { true, true, true, true };
+  std::vector<std::thread> interners;
+  for (int t=0; t < 4; ++t){
+    interners.push_back(std::thread(intern_names, t, &consistent[t]));
+  }
+  for (int t=0; t < 4; ++t){
+    interners[t].join();
+  }
+  assertTrue(unit, "concurrent interning",
+             consistent[0] && consistent[1] && consistent[2] && consistent[3]);
+  assertEqual(unit, "name after growth", latency_key.name(), std::string("latency"));
+#endif
+
+  sim_parameters params;
+  params.add_param("latency", "3ns");
+  params.add_param("node.count", "12");
+  assertTrue(unit, "has by key", params.has_param(latency_key));
+  assertEqual(unit, "get by key", params.get_param(latency_key), std::string("3ns"));
+  assertEqual(unit, "time by key", params.get_time_param(latency_key),
+              params.get_time_param("latency"));
+  sim_parameters* node = params.get_namespace("node");
+  assertEqual(unit, "inherited by key", node->get_param(latency_key), std::string("3ns"));
+  assertEqual(unit, "int by key", node->get_int_param(param_key("count")), 12);
+  assertTrue(unit, "find local", node->find_local_param("count") && !node->find_local_param(latency_key));
+
+  //only a locally defined value is copied
+  node->copy_optional_param("count", "ncount");
+  node->copy_optional_param("latency", "nlatency");
+  assertEqual(unit, "copied optional", node->get_param("ncount"), std::string("12"));
+  assertTrue(unit, "inherited not copied", !node->has_param("nlatency"));
+
+  int nparams = 0;
+  sim_parameters::const_iterator it, end = params.end();
+  for (it=params.begin(); it != end; ++it){
+    ++nparams;
+    assertEqual(unit, "iterated name", it->first, std::string("latency"));
+    assertEqual(unit, "iterated value", it->second, std::string("3ns"));
+  }
+  assertEqual(unit, "iterated count", nparams, 1);
+  assertEqual(unit, "iterator distance", int(std::distance(params.begin(), params.end())), 1);
+  std::iterator_traits<sim_parameters::iterator>::reference first = *params.begin();
+  assertEqual(unit, "iterator traits", first.first, std::string("latency"));
+
+  double cached = params.get_time_param(latency_key);
+  sim_parameters::iterator mit = params.begin();
+  mit->second = "5ns";
+  assertEqual(unit, "written through iterator", params.get_param("latency"), std::string("5ns"));
+  assertTrue(unit, "iterator write seen by cache", params.get_time_param(latency_key) != cached);
+}
+
+struct nic_config {
+  double latency;
+  double bandwidth;
+  long mtu;
+  int nports;
+  std::string name;
+};
+
+void
+test_param_handle(UnitTest& unit)
+{
+  sim_parameters params;
+  params.add_param("latency", "100ns");
+  params.add_param("nic.bandwidth", "10GB/s");
+  params.add_param("nic.nports", "4");
+  params.add_param("nic.name", "ib");
+  sim_parameters* nic = params.get_namespace("nic");
+
+  param_handle<double> lat(nic, "latency", &sim_parameters::get_time_param);
+  double latency = lat.get();
+  assertEqual(unit, "inherited handle", latency, params.get_time_param("latency"));
+  params.add_param_override("latency", "200ns");
+  assertEqual(unit, "handle after override", lat.get(), 2*latency);
+
+  param_handle<long> mtu(nic, "mtu", &sim_parameters::get_byte_length_param, 4096L);
+  assertEqual(unit, "handle default", mtu.get(), 4096L);
+  nic->add_param_override("mtu", "1KB");
+  assertTrue(unit, "handle sees new key", mtu.get() != 4096L);
+
+  param_binder<nic_config> binder;
+  binder.bind("latency", &nic_config::latency, &sim_parameters::get_time_param)
+        .bind("bandwidth", &nic_config::bandwidth, &sim_parameters::get_bandwidth_param)
+        .bind_optional("mtu", &nic_config::mtu, &sim_parameters::get_byte_length_param, 0L)
+        .bind_optional("credits", &nic_config::nports, &sim_parameters::get_int_param, 8)
+        .bind("name", &nic_config::name, &sim_parameters::get_param);
+  param_binder<nic_config> copy(binder);
+  assertEqual(unit, "binder fields", copy.size(), size_t(5));
+
+  nic_config cfg;
+  copy.fill(nic, cfg);
+  assertEqual(unit, "bound time", cfg.latency, lat.get());
+  assertEqual(unit, "bound bandwidth", cfg.bandwidth, nic->get_bandwidth_param("bandwidth"));
+  assertEqual(unit, "bound byte length", cfg.mtu, mtu.get());
+  assertEqual(unit, "bound default", cfg.nports, 8);
+  assertEqual(unit, "bound string", cfg.name, std::string("ib"));
+}
+
+void
+test_scoped_keys(UnitTest& unit)
+{
+  std::string path = "  a.bb.ccc = 1 ";
+  string_ref ref(path);
+  string_ref trimmed = ref.trim();
+  assertEqual(unit, "trim", trimmed.str(), std::string("a.bb.ccc = 1"));
+  assertEqual(unit, "find char", trimmed.find('.'), size_t(1));
+  assertEqual(unit, "find string", trimmed.find(" = "), size_t(8));
+  assertTrue(unit, "substr", trimmed.substr(2, 2) == "bb");
+  assertTrue(unit, "no match", trimmed.find('x') == string_ref::npos);
+  assertTrue(unit, "ordering", string_ref("ab") < string_ref("abc"));
+  assertEqual(unit, "hash matches string",
+              string_ref(std::string("latency")).hash(), string_ref("latency").hash());
+
+  sim_parameters params;
+  params.add_param("switch.xbar.bandwidth", "1GB/s");
+  params.add_param("switch.link.bandwidth", "2GB/s");
+  params.add_param("switch.arbitrator", "cut_through");
+  params.add_param("nic.injection.latency", "1us");
+  sim_parameters* sw = params.get_namespace("switch");
+  assertEqual(unit, "nested value",
+              sw->get_namespace("xbar")->get_param("bandwidth"), std::string("1GB/s"));
+  assertTrue(unit, "has namespace", sw->has_namespace("link"));
+  assertTrue(unit, "missing namespace", !sw->has_namespace("lin"));
+
+  std::vector<std::string> names;
+  sim_parameters::const_namespace_iterator it, end = sw->ns_end();
+  for (it=sw->ns_begin(); it != end; ++it){
+    names.push_back(it->first);
+  }
+  assertEqual(unit, "namespace count", names.size(), size_t(2));
+  assertEqual(unit, "sorted namespaces", names[0], std::string("link"));
+
+  std::stringstream sstr;
+  sstr << "unset switch.xbar.bandwidth\n";
+  params.parse_stream(sstr);
+  assertTrue(unit, "unset nested", !sw->get_namespace("xbar")->has_param("bandwidth"));
+}
+
+static void
+missing_param(sim_parameters* params)
+{
+  params->get_param("memory");
+}
+
+void
+test_find_param(UnitTest& unit)
+{
+  sim_parameters params;
+  params.add_param("node.ncores", "4");
+  params.add_param("node.nic.ncores", "2");
+  params.add_param("node.frequency", "2GHz");
+  sim_parameters* node = params.get_namespace("node");
+  sim_parameters* nic = node->get_namespace("nic");
+
+  const std::string* local = nic->find_param("ncores");
+  assertTrue(unit, "found local", local != 0);
+  assertEqual(unit, "local value", *local, std::string("2"));
+
+  const std::string* inherited = nic->find_param("frequency");
+  assertTrue(unit, "inherited is parent storage",
+             inherited == node->find_param("frequency"));
+  assertTrue(unit, "missing", nic->find_param("memory") == 0);
+
+  assertEqual(unit, "optional inherited", nic->get_optional_freq_param("frequency", 1e9), 2e9);
+  assertEqual(unit, "optional int local", nic->get_optional_int_param("ncores", 1), 2);
+  assertEqual(unit, "optional int default", nic->get_optional_int_param("nthread", 1), 1);
+  assertEqual(unit, "optional string default",
+              nic->get_optional_param("model", "simple"), std::string("simple"));
+  assertThrows(unit, "required missing", sprockit::value_error,
+               static_fxn(missing_param, nic));
+}
+
+static void
+write_frozen(sim_parameters* params)
+{
+  params->add_param_override("ncores", "8");
+}
+
+static void
+remove_frozen(sim_parameters* params)
+{
+  params->remove_param("ncores");
+}
+
+static void
+new_namespace_frozen(sim_parameters* params)
+{
+  params->add_param("disk.size", "1TB");
+}
+
+static void
+iterate_frozen(sim_parameters* params)
+{
+  params->begin()->second = "8";
+}
+
+void
+test_freeze(UnitTest& unit)
+{
+  sim_parameters params;
+  params.add_param("node.ncores", "4");
+  params.add_param("node.nic.ncores", "4");
+  params.add_param("node.nic.latency", "100ns");
+  params.add_param("node.frequency", "2GHz");
+  params.add_param("topology", "torus");
+  sim_parameters* node = params.get_namespace("node");
+  sim_parameters* nic = node->get_namespace("nic");
+
+  node->freeze();
+  assertTrue(unit, "whole tree frozen", params.is_frozen() && nic->is_frozen());
+  assertEqual(unit, "frozen value", params.get_param("topology"), std::string("torus"));
+  assertEqual(unit, "frozen inherited", nic->get_freq_param("frequency"), 2e9);
+  assertEqual(unit, "frozen time", nic->get_time_param("latency"), 100e-9);
+  assertEqual(unit, "frozen int", node->get_int_param("ncores"), 4);
+  assertEqual(unit, "frozen optional", nic->get_optional_int_param("nthread", 2), 2);
+  assertTrue(unit, "frozen has local", nic->has_param("latency"));
+  assertTrue(unit, "frozen has not inherited", !nic->has_param("frequency"));
+  assertTrue(unit, "equal values shared",
+             nic->find_param("ncores") == node->find_param("ncores"));
+
+  assertThrows(unit, "override frozen", sprockit::illformed_error,
+               static_fxn(write_frozen, node));
+  assertThrows(unit, "remove frozen", sprockit::illformed_error,
+               static_fxn(remove_frozen, nic));
+  assertThrows(unit, "new namespace frozen", sprockit::illformed_error,
+               static_fxn(new_namespace_frozen, &params));
+  assertThrows(unit, "write through iterator frozen", sprockit::illformed_error,
+               static_fxn(iterate_frozen, node));
+  assertEqual(unit, "unchanged after failed write", node->get_int_param("ncores"), 4);
+  assertTrue(unit, "no namespace after failed write", !params.has_namespace("disk"));
+  std::stringstream printed;
+  params.print_params(printed);
+  assertTrue(unit, "printable after failed write", !printed.str().empty());
+}
+
+#if SPKT_HAVE_CPP11
+static void
+read_versions(versioned_params* vp, bool* ordered)
+{
+  versioned_params::reader me(*vp);
+  uint64_t last = 0;
+  for (int i=0; i < 1000; ++i){
+    versioned_params::snapshot snap(me);
+    const std::string* val = snap.find_param("node", "ncores");
+    if (snap.version() < last || !val) *ordered = false;
+    last = snap.version();
+  }
+}
+
+void
+test_versioned_params(UnitTest& unit)
+{
+  sim_parameters params;
+  params.add_param("node.ncores", "4");
+  params.add_param("node.nic.latency", "100ns");
+  params.add_param("switch.arbitrator", "cut_through");
+  versioned_params vp(params);
+  versioned_params::reader me(vp);
+
+  const std::string* arb;
+  {
+    versioned_params::snapshot old(me);
+    arb = old.find_param("switch", "arbitrator");
+    vp.add_param_override("node.nic.latency", "200ns");
+    assertEqual(unit, "snapshot keeps its version",
+                *old.find_param("node.nic", "latency"), std::string("100ns"));
+    assertEqual(unit, "inherited in snapshot", *old.find_param("node.nic", "ncores"), std::string("4"));
+    assertEqual(unit, "replaced version pinned", vp.reclaim(), size_t(1));
+  }
+  assertEqual(unit, "replaced version freed", vp.reclaim(), size_t(0));
+
+  versioned_params::snapshot now(me);
+  assertEqual(unit, "new version", now.version(), uint64_t(1));
+  assertEqual(unit, "override visible", *now.find_param("node.nic", "latency"), std::string("200ns"));
+  assertTrue(unit, "untouched namespace shared", now.find_param("switch", "arbitrator") == arb);
+  assertEqual(unit, "missing namespace inherits",
+              *now.find_param("node.disk", "ncores"), std::string("4"));
+
+  vp.remove_param("node.ncores");
+  versioned_params::snapshot removed(me);
+  assertTrue(unit, "removed", removed.find_param("node", "ncores") == 0);
+  assertTrue(unit, "older snapshot unaffected", now.find_param("node", "ncores") != 0);
+
+  vp.add_param_override("node.ncores", "8");
+  bool ordered = true;
+  std::thread worker(read_versions, &vp, &ordered);
+  for (int i=0; i < 100; ++i){
+    vp.add_param_override("node.ncores", i % 2 ? "8" : "16");
+  }
+  worker.join();
+  assertTrue(unit, "concurrent versions ordered", ordered);
+}
+#endif
+
+void
+test_parse_text(UnitTest& unit)
+{
+  char fname[] = "/tmp/spkt_params_XXXXXX";
+  int fd = ::mkstemp(fname);
+  std::string included = "node.nic.latency = 100ns\n"
+                         "node.ncores = 2";
+  ::write(fd, included.c_str(), included.size());
+  ::close(fd);
+
+  std::stringstream sstr;
+  sstr << "# generated topology\n"
+       << "set var NCORES = 8\r\n"
+       << "\ttopology = torus \r\n"
+       << "\n"
+       << "include " << fname << "\n"
+       << "node.ncores = $NCORES\n"
+       << "node.nic.bandwidth = 10GB/s\n"
+       << "unset node.nic.bandwidth";
+  sim_parameters params;
+  params.parse_stream(sstr);
+  ::unlink(fname);
+
+  assertEqual(unit, "trimmed value", params.get_param("topology"), std::string("torus"));
+  assertEqual(unit, "variable", params.get_namespace("node")->get_int_param("ncores"), 8);
+  assertEqual(unit, "included file", params.get_namespace("node")->get_namespace("nic")->get_param("latency"),
+              std::string("100ns"));
+  assertTrue(unit, "unset last line",
+             !params.get_namespace("node")->get_namespace("nic")->has_param("bandwidth"));
+
+  sim_parameters text_params;
+  text_params.parse_text("node.frequency = 2GHz\nnode.ncores = 4\n");
+  assertEqual(unit, "parse text", text_params.get_namespace("node")->get_int_param("ncores"), 4);
+}
+
+static std::string
+write_temp_file(const std::string& text)
+{
+  char fname[] = "/tmp/spkt_params_XXXXXX";
+  int fd = ::mkstemp(fname);
+  ::write(fd, text.c_str(), text.size());
+  ::close(fd);
+  return fname;
+}
+
+void
+test_param_image(UnitTest& unit)
+{
+  std::string included = write_temp_file("node.nic.latency = 100ns\n");
+  std::string top = write_temp_file("set var N = 4\n"
+                                    "include " + included + "\n"
+                                    "node.ncores = $N\n");
+  std::string image = top + ".img";
+
+  sim_parameters parsed;
+  parsed.parse_file_cached(top, image);
+  assertEqual(unit, "sources recorded", parsed.source_files().size(), size_t(2));
+
+  sim_parameters loaded;
+  assertTrue(unit, "image up to date", loaded.load_image(image));
+  sim_parameters* node = loaded.get_namespace("node");
+  assertEqual(unit, "variable expanded", node->get_int_param("ncores"), 4);
+  assertEqual(unit, "include chased", node->get_namespace("nic")->get_time_param("latency"), 100e-9);
+  assertEqual(unit, "image sources", loaded.source_files().size(), size_t(2));
+
+  //same size and mtime, different contents
+  struct stat st;
+  ::stat(included.c_str(), &st);
+  std::ofstream out(included.c_str());
+  out << "node.nic.latency = 200ns\n";
+  out.close();
+#if SPKT_HAVE_STRUCT_STAT_ST_MTIM
+  struct timespec times[2];
+  times[0] = times[1] = st.st_mtim;
+  ::utimensat(AT_FDCWD, included.c_str(), times, 0);
+#endif
+  sim_parameters stale;
+  assertTrue(unit, "changed source detected", !stale.load_image(image));
+
+  sim_parameters rebuilt;
+  rebuilt.parse_file_cached(top, image);
+  sim_parameters reloaded;
+  assertTrue(unit, "image rebuilt", reloaded.load_image(image));
+  assertEqual(unit, "rebuilt value",
+              reloaded.get_namespace("node")->get_namespace("nic")->get_param("latency"),
+              std::string("200ns"));
+
+  sim_parameters not_image;
+  assertTrue(unit, "not an image", !not_image.load_image(top, false));
+
+  //cut off partway through the tree, as a half-written image would be
+  std::ifstream whole(image.c_str(), std::ios::binary);
+  std::string bytes((std::istreambuf_iterator<char>(whole)), std::istreambuf_iterator<char>());
+  whole.close();
+  std::string truncated = image + ".cut";
+  std::ofstream cut(truncated.c_str(), std::ios::binary);
+  cut.write(bytes.data(), bytes.size() - 8);
+  cut.close();
+  sim_parameters partial;
+  assertTrue(unit, "truncated image refused", !partial.load_image(truncated));
+  assertTrue(unit, "truncated image left no tree",
+             partial.begin() == partial.end() && partial.ns_begin() == partial.ns_end());
+
+  //a string length far past the end of the image
+  std::string bad_length = bytes;
+  size_t name_pos = bad_length.rfind("ncores");
+  int huge = 0x7fffffff;
+  ::memcpy(&bad_length[name_pos - sizeof(int)], &huge, sizeof(int));
+  std::string corrupt = image + ".bad";
+  std::ofstream bad(corrupt.c_str(), std::ios::binary);
+  bad.write(bad_length.data(), bad_length.size());
+  bad.close();
+  sim_parameters corrupted;
+  assertTrue(unit, "corrupt string length refused", !corrupted.load_image(corrupt));
+  assertTrue(unit, "corrupt image left no tree",
+             corrupted.begin() == corrupted.end() && corrupted.ns_begin() == corrupted.ns_end());
+
+  //an image built from one root does not stand in for another
+  std::string other = write_temp_file("node.ncores = 16\n");
+  sim_parameters other_params;
+  other_params.parse_file_cached(other, image);
+  assertEqual(unit, "other root reparsed",
+              other_params.get_namespace("node")->get_int_param("ncores"), 16);
+  sim_parameters top_again;
+  top_again.parse_file_cached(top, image);
+  assertEqual(unit, "root checked",
+              top_again.get_namespace("node")->get_int_param("ncores"), 4);
+
+  ::unlink(other.c_str());
+  ::unlink(truncated.c_str());
+  ::unlink(corrupt.c_str());
+
+  ::unlink(included.c_str());
+  ::unlink(top.c_str());
+  ::unlink(image.c_str());
+}
+
+static void
+parse_parallel(sim_parameters* params, std::string fname)
+{
+  params->parse_file_parallel(fname, 4);
+}
+
+void
+test_parallel_includes(UnitTest& unit)
+{
+  std::string first = write_temp_file("x = 1\ny = 1\nnode.ncores = 2\n");
+  std::string second = write_temp_file("x = 2\nset var V = 5\n");
+  std::string top = write_temp_file("set var N = 3\n"
+                                    "include " + first + "\n"
+                                    "include " + second + "\n"
+                                    "z = $V\n"
+                                    "node.nthread = $N\n"
+                                    "y = 3\n"
+                                    "include " + first + "\n");
+
+  sim_parameters serial;
+  serial.parse_file(top);
+  sim_parameters parallel;
+  parallel.parse_file_parallel(top, 4);
+  const char* keys[] = { "x", "y", "z" };
+  for (int i=0; i < 3; ++i){
+    assertEqual(unit, "same as serial", parallel.get_param(keys[i]), serial.get_param(keys[i]));
+  }
+  assertEqual(unit, "include order kept", parallel.get_int_param("y"), 1);
+  assertEqual(unit, "variable from include", parallel.get_int_param("z"), 5);
+  assertEqual(unit, "nested variable",
+              parallel.get_namespace("node")->get_int_param("nthread"), 3);
+  assertEqual(unit, "distinct files", parallel.source_files().size(), size_t(3));
+
+  std::string missing = write_temp_file("w = 1\ninclude /nonexistent/params.ini\n");
+  sim_parameters partial;
+  assertThrows(unit, "missing include", sprockit::io_error,
+               static_fxn(parse_parallel, &partial, missing));
+  assertEqual(unit, "applied before missing include", partial.get_int_param("w"), 1);
+
+#if SPKT_HAVE_CPP11
+  std::string cycle = write_temp_file("");
+  std::ofstream out(cycle.c_str());
+  out << "include " << cycle << "\n";
+  out.close();
+  sim_parameters cyclic;
+  assertThrows(unit, "include cycle", sprockit::input_error,
+               static_fxn(parse_parallel, &cyclic, cycle));
+  ::unlink(cycle.c_str());
+#endif
+
+  ::unlink(first.c_str());
+  ::unlink(second.c_str());
+  ::unlink(top.c_str());
+  ::unlink(missing.c_str());
+}
+
+int
+main(int argc, char** argv)
+{
+  KeywordRegistration::do_validation_ = false;
+  UnitTest unit;
+  SPROCKIT_RUN_TEST_NO_ARGS(test_value_cache, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_param_key, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_param_handle, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_scoped_keys, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_find_param, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_freeze, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_parse_text, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_param_image, unit);
+  SPROCKIT_RUN_TEST_NO_ARGS(test_parallel_includes, unit);
+#if SPKT_HAVE_CPP11
+  SPROCKIT_RUN_TEST_NO_ARGS(test_versioned_params, unit);
+#endif
+  return unit.validate(std::cout);
+}